@@ -0,0 +1,452 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_BINARY_HPP
+#define CPM_BINARY_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <unordered_map>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "duration.hpp"
+
+/*
+ * Binary result format (.cpmb), in native byte order:
+ *
+ *  - binary_header, the environment of the run is a string of JSON
+ *  - string table: n_strings {offset, length} entries, then the characters
+ *    of the strings, each terminated by a '\0'
+ *  - n_series binary_series, the results of the benches and the results of
+ *    each implementation of the sections
+ *  - the columns of the n_points points of all the series: size_eff, the
+ *    flops, the nine metrics, then the size, regime and coordinates string
+ *    ids
+ *
+ * All the sections are aligned on 8 bytes so that the file can be used in
+ * place once mapped in memory.
+ */
+
+namespace cpm {
+
+constexpr const char binary_magic[4] = {'C', 'P', 'M', 'B'};
+constexpr const std::uint32_t binary_version = 1;
+constexpr const std::uint32_t binary_none = 0xFFFFFFFF; //No string
+
+struct binary_header {
+    char magic[4];
+    std::uint32_t version;
+    std::uint64_t file_size;
+
+    std::uint32_t name;
+    std::uint32_t tag;
+    std::uint32_t configuration;
+    std::uint32_t compiler;
+    std::uint32_t os;
+    std::uint32_t shard;
+    std::uint32_t time;
+    std::uint32_t n_strings;
+
+    std::int64_t timestamp;
+
+    std::uint32_t n_series;
+    std::uint32_t n_points;
+
+    std::uint64_t strings;
+    std::uint64_t series;
+    std::uint64_t columns;
+
+    std::uint32_t environment;
+    std::uint32_t seed; //Seed of the random order of the measures, 0 if not randomized
+};
+
+static_assert(sizeof(binary_header) == 96, "Invalid binary header layout");
+
+struct binary_string {
+    std::uint32_t offset;
+    std::uint32_t length;
+};
+
+struct binary_series {
+    std::uint32_t section; //binary_none for the results of a bench
+    std::uint32_t title;   //Title of the bench or name of the implementation
+    std::uint32_t first;   //First point of the series
+    std::uint32_t count;   //Number of points of the series
+    std::int64_t duration;
+};
+
+static_assert(sizeof(binary_series) == 24, "Invalid binary series layout");
+
+//The metric columns, stored after size_eff and the flops
+enum binary_metric {
+    BINARY_MEAN,
+    BINARY_MEAN_LB,
+    BINARY_MEAN_UB,
+    BINARY_STDDEV,
+    BINARY_MIN,
+    BINARY_MAX,
+    BINARY_THROUGHPUT_E,
+    BINARY_THROUGHPUT_F,
+    BINARY_NOISE, //Negative if not monitored
+    BINARY_METRICS
+};
+
+namespace detail {
+
+inline std::uint64_t binary_align(std::uint64_t offset){
+    return (offset + 7) & ~std::uint64_t(7);
+}
+
+} //end of namespace detail
+
+/*
+ * Builder of binary result files. The strings are interned in the string
+ * table and the points are accumulated in columns until write().
+ */
+struct binary_writer {
+    binary_writer(){
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, binary_magic, sizeof(binary_magic));
+        header.version = binary_version;
+        header.shard = binary_none;
+        header.environment = binary_none;
+    }
+
+    std::uint32_t string(const std::string& value){
+        auto it = ids.find(value);
+
+        if(it != ids.end()){
+            return it->second;
+        }
+
+        auto id = static_cast<std::uint32_t>(table.size());
+
+        table.push_back({static_cast<std::uint32_t>(characters.size()), static_cast<std::uint32_t>(value.size())});
+        characters.insert(characters.end(), value.begin(), value.end());
+        characters.push_back('\0');
+
+        ids.emplace(value, id);
+
+        return id;
+    }
+
+    void run(const std::string& name, const std::string& tag, const std::string& configuration, const std::string& compiler,
+             const std::string& os, const std::string& time, std::int64_t timestamp, const std::string& shard = ""){
+        header.name          = string(name);
+        header.tag           = string(tag);
+        header.configuration = string(configuration);
+        header.compiler      = string(compiler);
+        header.os            = string(os);
+        header.time          = string(time);
+        header.shard         = shard.empty() ? binary_none : string(shard);
+        header.timestamp     = timestamp;
+    }
+
+    //The environment of the run, as a JSON object
+    void environment(const std::string& json){
+        header.environment = json.empty() ? binary_none : string(json);
+    }
+
+    void seed(std::uint32_t seed){
+        header.seed = seed;
+    }
+
+    //Start the results of a bench (empty section) or of an implementation of a section
+    void start_series(const std::string& section, const std::string& title, std::int64_t duration){
+        series.push_back({section.empty() ? binary_none : string(section), string(title), static_cast<std::uint32_t>(size_eff.size()), 0, duration});
+    }
+
+    //Add a point to the current series, the coordinates are the JSON array or empty
+    void point(const std::string& size, std::size_t eff, const std::string& regime, const std::string& coordinates, const measure_result& result){
+        sizes.push_back(string(size));
+        size_eff.push_back(eff);
+        flops.push_back(result.flops);
+        regimes.push_back(regime.empty() ? binary_none : string(regime));
+        coordinates_ids.push_back(coordinates.empty() ? binary_none : string(coordinates));
+
+        metrics[BINARY_MEAN].push_back(result.mean);
+        metrics[BINARY_MEAN_LB].push_back(result.mean_lb);
+        metrics[BINARY_MEAN_UB].push_back(result.mean_ub);
+        metrics[BINARY_STDDEV].push_back(result.stddev);
+        metrics[BINARY_MIN].push_back(result.min);
+        metrics[BINARY_MAX].push_back(result.max);
+        metrics[BINARY_THROUGHPUT_E].push_back(result.throughput_e);
+        metrics[BINARY_THROUGHPUT_F].push_back(result.throughput_f);
+        metrics[BINARY_NOISE].push_back(result.noise);
+
+        ++series.back().count;
+    }
+
+    bool write(const std::string& path){
+        std::ofstream stream(path, std::ios::binary);
+
+        write(stream);
+
+        stream.close();
+
+        return static_cast<bool>(stream);
+    }
+
+    void write(std::ostream& stream){
+        header.n_strings = table.size();
+        header.n_series  = series.size();
+        header.n_points  = size_eff.size();
+
+        header.strings   = detail::binary_align(sizeof(binary_header));
+        header.series    = detail::binary_align(header.strings + table.size() * sizeof(binary_string) + characters.size());
+        header.columns   = header.series + series.size() * sizeof(binary_series);
+        header.file_size = header.columns + size_eff.size() * (2 * sizeof(std::uint64_t) + BINARY_METRICS * sizeof(double) + 3 * sizeof(std::uint32_t));
+
+        std::uint64_t position = 0;
+
+        auto pad = [&stream, &position](std::uint64_t offset){
+            static const char zeroes[8] = {};
+            stream.write(zeroes, offset - position);
+            position = offset;
+        };
+
+        auto column = [&stream, &position](const auto& values){
+            stream.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(values[0]));
+            position += values.size() * sizeof(values[0]);
+        };
+
+        stream.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        position += sizeof(header);
+
+        pad(header.strings);
+        column(table);
+        column(characters);
+
+        pad(header.series);
+        column(series);
+
+        column(size_eff);
+        column(flops);
+
+        for(auto& metric : metrics){
+            column(metric);
+        }
+
+        column(sizes);
+        column(regimes);
+        column(coordinates_ids);
+    }
+
+private:
+    binary_header header;
+
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::vector<binary_string> table;
+    std::vector<char> characters;
+
+    std::vector<binary_series> series;
+
+    std::vector<std::uint64_t> size_eff;
+    std::vector<std::uint64_t> flops;
+    std::vector<double> metrics[BINARY_METRICS];
+    std::vector<std::uint32_t> sizes;
+    std::vector<std::uint32_t> regimes;
+    std::vector<std::uint32_t> coordinates_ids;
+};
+
+//Read-only memory mapping of a complete file
+struct file_mapping {
+    file_mapping() = default;
+
+    file_mapping(const file_mapping&) = delete;
+    file_mapping& operator=(const file_mapping&) = delete;
+
+    ~file_mapping(){
+        close();
+    }
+
+    //A writable mapping is private, the changes are not written to the file
+    bool open(const std::string& path, bool writable = false){
+        close();
+
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+        if(fd < 0){
+            return false;
+        }
+
+        struct stat buffer;
+        if(fstat(fd, &buffer) != 0 || buffer.st_size == 0){
+            ::close(fd);
+            return false;
+        }
+
+        auto address = mmap(nullptr, buffer.st_size, writable ? PROT_READ | PROT_WRITE : PROT_READ, MAP_PRIVATE, fd, 0);
+
+        ::close(fd);
+
+        if(address == MAP_FAILED){
+            return false;
+        }
+
+        data = static_cast<char*>(address);
+        size = buffer.st_size;
+
+        return true;
+    }
+
+    void close(){
+        if(data){
+            munmap(data, size);
+            data = nullptr;
+            size = 0;
+        }
+    }
+
+    char* data = nullptr;
+    std::size_t size = 0;
+};
+
+/*
+ * Read-only view of a binary result, either a mapped file or a record of a
+ * mapped results store. The strings and the columns are used in place,
+ * nothing is copied.
+ */
+struct binary_file {
+
+    //Test if the file starts with the binary magic
+    static bool is_binary(const std::string& path){
+        char magic[sizeof(binary_magic)];
+
+        std::ifstream stream(path, std::ios::binary);
+        stream.read(magic, sizeof(magic));
+
+        return stream && std::memcmp(magic, binary_magic, sizeof(magic)) == 0;
+    }
+
+    //Map the file, the view is valid as long as the binary_file
+    bool open(const std::string& path){
+        return mapping.open(path) && open(mapping.data, mapping.size);
+    }
+
+    //View a binary result in memory, the memory must outlive the view
+    bool open(const char* memory, std::size_t length){
+        data = memory;
+        size = length;
+
+        if(size < sizeof(binary_header) || reinterpret_cast<std::uintptr_t>(data) % 8 || !validate()){
+            data = nullptr;
+            size = 0;
+            return false;
+        }
+
+        return true;
+    }
+
+    const binary_header& header() const {
+        return *reinterpret_cast<const binary_header*>(data);
+    }
+
+    //The string of the given id, empty for binary_none
+    const char* string(std::uint32_t id) const {
+        return id < header().n_strings ? characters() + strings()[id].offset : "";
+    }
+
+    std::uint32_t length(std::uint32_t id) const {
+        return id < header().n_strings ? strings()[id].length : 0;
+    }
+
+    const binary_series* series() const {
+        return reinterpret_cast<const binary_series*>(data + header().series);
+    }
+
+    const std::uint64_t* size_eff() const {
+        return reinterpret_cast<const std::uint64_t*>(data + header().columns);
+    }
+
+    const std::uint64_t* flops() const {
+        return size_eff() + header().n_points;
+    }
+
+    const double* metric(binary_metric metric) const {
+        return reinterpret_cast<const double*>(flops() + header().n_points) + metric * header().n_points;
+    }
+
+    //The measure of a point
+    measure_result result(std::size_t point) const {
+        measure_result result{metric(BINARY_MEAN)[point], metric(BINARY_MEAN_LB)[point], metric(BINARY_MEAN_UB)[point], metric(BINARY_STDDEV)[point],
+            metric(BINARY_MIN)[point], metric(BINARY_MAX)[point], metric(BINARY_THROUGHPUT_E)[point], metric(BINARY_THROUGHPUT_F)[point], flops()[point]};
+
+        result.noise = metric(BINARY_NOISE)[point];
+
+        return result;
+    }
+
+    const std::uint32_t* sizes() const {
+        return reinterpret_cast<const std::uint32_t*>(metric(BINARY_MEAN) + BINARY_METRICS * header().n_points);
+    }
+
+    const std::uint32_t* regimes() const {
+        return sizes() + header().n_points;
+    }
+
+    const std::uint32_t* coordinates() const {
+        return regimes() + header().n_points;
+    }
+
+private:
+    const binary_string* strings() const {
+        return reinterpret_cast<const binary_string*>(data + header().strings);
+    }
+
+    const char* characters() const {
+        return reinterpret_cast<const char*>(strings() + header().n_strings);
+    }
+
+    //Verify that all the offsets of the file are in bounds
+    bool validate() const {
+        auto& h = header();
+
+        if(std::memcmp(h.magic, binary_magic, sizeof(binary_magic)) != 0 || h.version != binary_version || h.file_size != size){
+            return false;
+        }
+
+        std::uint64_t characters_size = h.series - (h.strings + std::uint64_t(h.n_strings) * sizeof(binary_string));
+
+        if(h.strings < sizeof(binary_header) || h.series < h.strings + std::uint64_t(h.n_strings) * sizeof(binary_string)
+                || h.columns != h.series + std::uint64_t(h.n_series) * sizeof(binary_series)
+                || h.file_size != h.columns + std::uint64_t(h.n_points) * (2 * sizeof(std::uint64_t) + BINARY_METRICS * sizeof(double) + 3 * sizeof(std::uint32_t))
+                || h.strings % 8 || h.series % 8){
+            return false;
+        }
+
+        for(std::size_t i = 0; i < h.n_strings; ++i){
+            if(std::uint64_t(strings()[i].offset) + strings()[i].length >= characters_size || characters()[strings()[i].offset + strings()[i].length] != '\0'){
+                return false;
+            }
+        }
+
+        for(std::size_t i = 0; i < h.n_series; ++i){
+            if(std::uint64_t(series()[i].first) + series()[i].count > h.n_points){
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    file_mapping mapping;
+
+    const char* data = nullptr;
+    std::size_t size = 0;
+};
+
+} //end of namespace cpm
+
+#endif //CPM_BINARY_HPP
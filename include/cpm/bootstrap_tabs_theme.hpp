@@ -20,10 +20,10 @@ struct bootstrap_tabs_theme : bootstrap_theme {
 
     std::vector<std::string> matches;
 
-    bootstrap_tabs_theme(const reports_data& data, cxxopts::Options& options, std::ostream& stream, std::string compiler, std::string configuration) : bootstrap_theme(data, options, stream, compiler, configuration) {}
+    bootstrap_tabs_theme(const reports_data& data, const report_page& page, cxxopts::Options& options, page_buffer& stream, std::string compiler, std::string configuration) : bootstrap_theme(data, page, options, stream, compiler, configuration) {}
 
-    void before_result(const std::string& title, bool sub, const std::vector<cpm::document_cref>& documents){
-        bootstrap_theme::before_result(title, sub, documents);
+    void before_result(const std::string& title, bool sub, const std::vector<std::size_t>& runs){
+        bootstrap_theme::before_result(title, sub, runs);
 
         stream << "<div class=\"col-xs-12\">\n";
         stream << "<div role=\"tabpanel\">\n";
@@ -36,7 +36,7 @@ struct bootstrap_tabs_theme : bootstrap_theme {
             << uid << '_' << tab_id << "\" role=\"tab\" data-toggle=\"tab\">Last results</a></li>\n";
         ++tab_id;
 
-        if(documents.size() > 1 && !options.count("disable-time")){
+        if(runs.size() > 1 && !options.count("disable-time")){
             stream
                 << "<li role=\"presentation\"><a href=\"#tab_" << uid << '_' << tab_id << "\" aria-controls=\"tab_"
                 << uid << '_' << tab_id << "\" role=\"tab\" data-toggle=\"tab\">Results over time</a></li>\n";
@@ -75,7 +75,7 @@ struct bootstrap_tabs_theme : bootstrap_theme {
             stream << "$('a[data-toggle=\"tab\"]').on( 'shown.bs.tab', function (e) {\n";
             stream << "$(\".cpm_chart\").each(function(){\n";
             stream << "var chart = $(this).highcharts();\n";
-            stream << "chart.reflow();\n";
+            stream << "if(chart){ chart.reflow(); }\n";
             stream << "});\n";
             stream << "});\n";
             stream << "});\n";
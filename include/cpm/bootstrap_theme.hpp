@@ -15,15 +15,16 @@ namespace cpm {
 
 struct bootstrap_theme {
     const reports_data& data;
+    const report_page& page;
     cxxopts::Options& options;
-    std::ostream& stream;
+    page_buffer& stream;
     std::string current_compiler;
     std::string current_configuration;
 
     std::size_t current_column = 0;
 
-    bootstrap_theme(const reports_data& data, cxxopts::Options& options, std::ostream& stream, std::string compiler, std::string configuration)
-        : data(data), options(options), stream(stream), current_compiler(std::move(compiler)), current_configuration(std::move(configuration)) {}
+    bootstrap_theme(const reports_data& data, const report_page& page, cxxopts::Options& options, page_buffer& stream, std::string compiler, std::string configuration)
+        : data(data), page(page), options(options), stream(stream), current_compiler(std::move(compiler)), current_configuration(std::move(configuration)) {}
 
     void include(){
         stream << "<script src=\"https://maxcdn.bootstrapcdn.com/bootstrap/3.3.4/js/bootstrap.min.js\"></script>\n";
@@ -61,8 +62,13 @@ struct bootstrap_theme {
             <div class="collapse navbar-collapse" id="navbarCollapse">
             <ul class="nav navbar-nav">
             <li class="active"><a href="index.html">Home</a></li>
+            <li><a href="regressions.html">Regressions</a></li>
             <li><a href="https://github.com/wichtounet/cpm">Generated with CPM</a></li>
             </ul>
+            <form class="navbar-form navbar-right" role="search" style="position: relative;">
+            <input id="cpm_search" type="text" class="form-control" placeholder="Search" autocomplete="off">
+            <ul id="cpm_search_results" class="dropdown-menu"></ul>
+            </form>
             </div>
             </div>
             </nav>
@@ -115,7 +121,7 @@ struct bootstrap_theme {
 
         if(options.count("pages")){
             for(auto& compiler : data.compilers){
-                auto file = cpm::filify(compiler, current_configuration, data.sub_part);
+                auto file = cpm::filify(compiler, current_configuration, page.sub_part);
                 if(compiler == current_compiler){
                     stream << "<a class=\"btn btn-primary\" href=\"" << file << "\">" << compiler << "</a>\n";
                 } else {
@@ -153,7 +159,7 @@ struct bootstrap_theme {
 
         if(options.count("pages")){
             for(auto& configuration : data.configurations){
-                auto file = cpm::filify(current_compiler, configuration, data.sub_part);
+                auto file = cpm::filify(current_compiler, configuration, page.sub_part);
                 if(configuration == current_configuration){
                     stream << "<a class=\"btn btn-primary\" href=\"" << file  << "\">" << configuration << "</a>\n";
                 } else {
@@ -192,8 +198,8 @@ struct bootstrap_theme {
                 <ul class="nav nav-stacked" id="sidebar">
             )=====";
 
-            for(auto& link : data.files){
-                stream << "<li><a href=\"" << link.second << "\">" << link.first << "</a></li>" << std::endl;
+            for(auto& link : page.files){
+                stream << "<li><a href=\"" << link.second << "\">" << link.first << "</a></li>\n";
             }
 
             stream << R"=====(
@@ -210,7 +216,7 @@ struct bootstrap_theme {
     virtual void start_column(const std::string& style = ""){
         std::size_t columns = 1; //Always the first grapah
 
-        if(data.documents.size() > 1 && !options.count("disable-time")){
+        if(data.runs.size() > 1 && !options.count("disable-time")){
             ++columns;
         }
 
@@ -267,7 +273,7 @@ struct bootstrap_theme {
         close_column();
     }
 
-    void before_result(const std::string& title, bool sub, const std::vector<cpm::document_cref>& /*documents*/){
+    void before_result(const std::string& title, bool sub, const std::vector<std::size_t>& /*runs*/){
         stream << "<div class=\"page-header\">\n";
         stream << "<h2>" << title << "</h2>\n";
         stream << "</div>\n";
@@ -338,6 +344,18 @@ struct bootstrap_theme {
         close_column();
     }
 
+    void before_regressions(){
+        stream << "<div class=\"row\">\n";
+        stream << "<div class=\"col-xs-12\">\n";
+        stream << "<table class=\"table\">\n";
+    }
+
+    void after_regressions(){
+        stream << "</table>\n";
+        stream << "</div>\n";
+        stream << "</div>\n";
+    }
+
     void before_sub_summary(std::size_t id, std::size_t sub){
         auto sub_id = std::string("sub") + std::to_string(id) + "-" + std::to_string(sub);
         std::string active;
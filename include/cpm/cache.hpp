@@ -0,0 +1,264 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_CACHE_HPP
+#define CPM_CACHE_HPP
+
+#include <map>
+#include <set>
+#include <tuple>
+#include <string>
+#include <cerrno>
+#include <cstdio>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include "json.hpp"
+#include "journal.hpp"
+
+namespace cpm {
+
+//Group of results, the bench is empty for all the benches of the compiler and configuration
+using report_group = std::tuple<std::string, std::string, std::string>; //(compiler, configuration, bench)
+
+//Groups of results changed since the last generation of the report
+struct report_changes {
+    bool all = false; //Everything must be regenerated
+    std::set<report_group> groups;
+
+    void add(const std::string& compiler, const std::string& configuration, const std::string& bench = ""){
+        groups.emplace(compiler, configuration, bench);
+    }
+};
+
+//FNV-1a hash, stable between runs
+inline std::uint64_t fnv1a(const std::string& value, std::uint64_t hash = 14695981039346656037ULL){
+    for(unsigned char c : value){
+        hash ^= c;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+//Source of the report, a result file or a record of the results store
+struct cache_source {
+    std::int64_t size;
+    std::int64_t mtime;
+    std::string cache; //Cached binary document, empty for the records of the store
+    std::string compiler;
+    std::string configuration;
+};
+
+//Generated page and what it depends on
+struct cache_page {
+    std::string compiler;      //Empty with the configuration for all the compilers and configurations
+    std::string configuration;
+    std::string bench;         //Empty if the page contains all the benches
+    std::uint64_t signature;
+};
+
+/*
+ * Persistent state of the reports of an output folder, kept in its .cpm
+ * folder.
+ *
+ * The parse cache keeps the binary form of each source file, keyed by its
+ * path, its size and its modification time, so that the unchanged files are
+ * mapped instead of being parsed again.
+ *
+ * The manifest records for each page the groups of results it depends on
+ * and the signature of its other inputs. A page is only generated again if
+ * one of its groups changed or if its signature changed.
+ */
+struct report_cache {
+    explicit report_cache(const std::string& target) : folder(target + "/.cpm/") {
+        enabled = mkdir(folder.c_str(), 0755) == 0 || errno == EEXIST;
+
+        if(enabled){
+            load();
+        }
+    }
+
+    //Test if the source is unchanged since the last generation (and its cached document still present)
+    bool unchanged(const std::string& source, std::int64_t size, std::int64_t mtime){
+        auto it = sources.find(source);
+
+        if(it == sources.end() || it->second.size != size || it->second.mtime != mtime){
+            return false;
+        }
+
+        if(!it->second.cache.empty() && access((folder + it->second.cache).c_str(), R_OK) != 0){
+            return false;
+        }
+
+        seen.insert(source);
+
+        return true;
+    }
+
+    //The file where to cache the document of the source
+    std::string cache_file(const std::string& source) const {
+        char name[32];
+        snprintf(name, sizeof(name), "%016llx.cpmb", static_cast<unsigned long long>(fnv1a(source)));
+        return name;
+    }
+
+    std::string path(const std::string& file) const {
+        return folder + file;
+    }
+
+    //The previous state of the source, nullptr if it is new
+    const cache_source* previous(const std::string& source) const {
+        auto it = sources.find(source);
+        return it == sources.end() ? nullptr : &it->second;
+    }
+
+    void update(const std::string& source, cache_source value){
+        sources[source] = std::move(value);
+        seen.insert(source);
+    }
+
+    //Forget the sources that were not seen, their cached documents are removed
+    void remove_unseen(report_changes& changes){
+        for(auto it = sources.begin(); it != sources.end();){
+            if(seen.count(it->first)){
+                ++it;
+                continue;
+            }
+
+            changes.add(it->second.compiler, it->second.configuration);
+
+            if(!it->second.cache.empty()){
+                unlink((folder + it->second.cache).c_str());
+            }
+
+            it = sources.erase(it);
+        }
+    }
+
+    //Test if the page must be generated
+    bool dirty(const std::string& file, const cache_page& page, const report_changes& changes, const std::string& target) const {
+        auto it = pages.find(file);
+
+        if(changes.all || it == pages.end() || it->second.signature != page.signature || access((target + "/" + file).c_str(), F_OK) != 0){
+            return true;
+        }
+
+        //The page shows the results of its compiler with all the configurations and the reverse,
+        //a page without compiler and configuration shows the results of all of them
+        bool all = page.compiler.empty() && page.configuration.empty();
+
+        for(auto& group : changes.groups){
+            if((all || std::get<0>(group) == page.compiler || std::get<1>(group) == page.configuration)
+                    && (page.bench.empty() || std::get<2>(group).empty() || std::get<2>(group) == page.bench)){
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void generated(const std::string& file, cache_page page){
+        next_pages[file] = std::move(page);
+    }
+
+    void save(){
+        if(!enabled){
+            return;
+        }
+
+        std::string sources_content;
+        for(auto& source : sources){
+            sources_content +=
+                  "{\"source\": \"" + json_escape(source.first)
+                + "\", \"size\": " + std::to_string(source.second.size)
+                + ", \"mtime\": " + std::to_string(source.second.mtime)
+                + ", \"cache\": \"" + json_escape(source.second.cache)
+                + "\", \"compiler\": \"" + json_escape(source.second.compiler)
+                + "\", \"configuration\": \"" + json_escape(source.second.configuration) + "\"}\n";
+        }
+
+        std::string pages_content;
+        for(auto& page : next_pages){
+            pages_content +=
+                  "{\"page\": \"" + json_escape(page.first)
+                + "\", \"compiler\": \"" + json_escape(page.second.compiler)
+                + "\", \"configuration\": \"" + json_escape(page.second.configuration)
+                + "\", \"bench\": \"" + json_escape(page.second.bench)
+                + "\", \"signature\": " + std::to_string(page.second.signature) + "}\n";
+        }
+
+        replace(folder + "sources", sources_content);
+        replace(folder + "pages", pages_content);
+    }
+
+    bool enabled;
+
+private:
+    void load(){
+        std::map<std::string, std::string> values;
+
+        std::ifstream sources_stream(folder + "sources");
+
+        std::string line;
+        while(std::getline(sources_stream, line)){
+            values.clear();
+
+            if(detail::parse_journal_line(line, values)){
+                auto& source = sources[values["source"]];
+                source.size          = std::strtoll(values["size"].c_str(), nullptr, 10);
+                source.mtime         = std::strtoll(values["mtime"].c_str(), nullptr, 10);
+                source.cache         = values["cache"];
+                source.compiler      = values["compiler"];
+                source.configuration = values["configuration"];
+            }
+        }
+
+        std::ifstream pages_stream(folder + "pages");
+
+        while(std::getline(pages_stream, line)){
+            values.clear();
+
+            if(detail::parse_journal_line(line, values)){
+                auto& page = pages[values["page"]];
+                page.compiler      = values["compiler"];
+                page.configuration = values["configuration"];
+                page.bench         = values["bench"];
+                page.signature     = std::strtoull(values["signature"].c_str(), nullptr, 10);
+            }
+        }
+    }
+
+    //Replace the file at once, an interrupted generation keeps the previous one
+    static void replace(const std::string& file, const std::string& content){
+        auto temporary = file + ".tmp";
+
+        std::ofstream stream(temporary);
+        stream << content;
+        stream.close();
+
+        if(stream){
+            std::rename(temporary.c_str(), file.c_str());
+        }
+    }
+
+    std::string folder;
+
+    std::map<std::string, cache_source> sources;
+    std::set<std::string> seen;
+
+    std::map<std::string, cache_page> pages;
+    std::map<std::string, cache_page> next_pages;
+};
+
+} //end of namespace cpm
+
+#endif //CPM_CACHE_HPP
@@ -0,0 +1,209 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_CHANGEPOINT_HPP
+#define CPM_CHANGEPOINT_HPP
+
+#include <cmath>
+#include <limits>
+#include <vector>
+#include <algorithm>
+
+namespace cpm {
+
+//Shift of the mean of a series
+struct change_point {
+    std::size_t index; //First point after the shift
+    double before;     //Mean of the segment before the shift
+    double after;      //Mean of the segment after the shift
+};
+
+/*
+ * Noise of a series, learned from its history: the standard deviation
+ * estimated from the median absolute difference of consecutive points,
+ * which is not inflated by the shifts of the mean.
+ */
+inline double noise_sigma(const std::vector<double>& values){
+    if(values.size() < 2){
+        return 0.0;
+    }
+
+    std::vector<double> differences;
+    for(std::size_t i = 1; i < values.size(); ++i){
+        differences.push_back(std::fabs(values[i] - values[i - 1]));
+    }
+
+    auto middle = differences.begin() + differences.size() / 2;
+    std::nth_element(differences.begin(), middle, differences.end());
+
+    //1.4826 * MAD estimates sigma, the difference of two points has sqrt(2) sigma
+    return 1.4826 * *middle / std::sqrt(2.0);
+}
+
+/*
+ * Pruned exact linear time (PELT) segmentation of the mean of a series with
+ * a Gaussian cost of unit variance. Each segment has at least min_size
+ * points and each change point costs the penalty. Returns the first index
+ * of each segment after the first one.
+ */
+inline std::vector<std::size_t> pelt(const std::vector<double>& values, double penalty, std::size_t min_size = 2){
+    std::vector<std::size_t> points;
+
+    auto n = values.size();
+
+    if(n < 2 * min_size){
+        return points;
+    }
+
+    std::vector<double> sum(n + 1, 0.0);
+    std::vector<double> sum_squares(n + 1, 0.0);
+
+    for(std::size_t i = 0; i < n; ++i){
+        sum[i + 1] = sum[i] + values[i];
+        sum_squares[i + 1] = sum_squares[i] + values[i] * values[i];
+    }
+
+    //Sum of the squared deviations of the segment [s, t)
+    auto cost = [&](std::size_t s, std::size_t t){
+        double s1 = sum[t] - sum[s];
+        return (sum_squares[t] - sum_squares[s]) - s1 * s1 / (t - s);
+    };
+
+    const double infinity = std::numeric_limits<double>::infinity();
+
+    std::vector<double> best(n + 1, infinity);
+    std::vector<std::size_t> last(n + 1, 0);
+    std::vector<std::size_t> candidates;
+
+    best[0] = -penalty;
+
+    for(std::size_t t = min_size; t <= n; ++t){
+        if(best[t - min_size] < infinity){
+            candidates.push_back(t - min_size);
+        }
+
+        for(auto s : candidates){
+            auto value = best[s] + cost(s, t) + penalty;
+
+            if(value < best[t]){
+                best[t] = value;
+                last[t] = s;
+            }
+        }
+
+        //The candidates that cannot be optimal anymore are pruned
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(), [&](std::size_t s){
+            return best[s] + cost(s, t) > best[t];
+        }), candidates.end());
+    }
+
+    for(auto t = last[n]; t > 0; t = last[t]){
+        points.push_back(t);
+    }
+
+    std::reverse(points.begin(), points.end());
+
+    return points;
+}
+
+/*
+ * Replace the isolated spikes of a normalized series by their neighbours, a
+ * spike is a point further than k from its neighbours while they agree. The
+ * first and the last points are spikes if they are far from their only
+ * neighbour, a shift needs two points to be confirmed.
+ */
+inline void despike(std::vector<double>& values, double k = 5.0){
+    auto n = values.size();
+
+    if(n < 3){
+        return;
+    }
+
+    std::vector<double> result(values);
+
+    for(std::size_t i = 1; i + 1 < n; ++i){
+        if(std::fabs(values[i] - values[i - 1]) > k && std::fabs(values[i] - values[i + 1]) > k && std::fabs(values[i - 1] - values[i + 1]) <= k){
+            result[i] = (values[i - 1] + values[i + 1]) / 2.0;
+        }
+    }
+
+    if(std::fabs(values[0] - values[1]) > k){
+        result[0] = values[1];
+    }
+
+    if(std::fabs(values[n - 1] - values[n - 2]) > k){
+        result[n - 1] = values[n - 2];
+    }
+
+    values.swap(result);
+}
+
+/*
+ * Detect the shifts of the mean of a series. The series is normalized by
+ * its noise, despiked and segmented with PELT. The consecutive segments
+ * are then merged as long as they stay within the relative threshold of the
+ * first segment of the level, so that a slow creep is reported once it
+ * crossed the threshold instead of being lost in small steps.
+ */
+inline std::vector<change_point> detect_changes(const std::vector<double>& values, double threshold = 0.05, double beta = 3.0){
+    std::vector<change_point> changes;
+
+    if(values.size() < 4){
+        return changes;
+    }
+
+    double mean = 0.0;
+    for(auto v : values){
+        mean += std::fabs(v);
+    }
+    mean /= values.size();
+
+    //A perfectly stable history still has some noise
+    auto sigma = std::max(noise_sigma(values), 1e-3 * mean);
+
+    if(sigma == 0.0){
+        return changes;
+    }
+
+    std::vector<double> normalized;
+    for(auto v : values){
+        normalized.push_back(v / sigma);
+    }
+
+    despike(normalized);
+
+    auto points = pelt(normalized, beta * std::log(double(values.size())));
+    points.push_back(values.size());
+
+    auto segment_mean = [&normalized, sigma](std::size_t first, std::size_t last){
+        double sum = 0.0;
+        for(auto i = first; i < last; ++i){
+            sum += normalized[i];
+        }
+        return sigma * sum / (last - first);
+    };
+
+    std::size_t level_first = 0;
+    double level = segment_mean(0, points[0]);
+
+    for(std::size_t i = 0; i + 1 < points.size(); ++i){
+        auto after = segment_mean(points[i], points[i + 1]);
+
+        if(level != 0.0 && std::fabs(after - level) / std::fabs(level) >= threshold){
+            changes.push_back({points[i], segment_mean(level_first, points[i]), after});
+
+            level_first = points[i];
+            level = after;
+        }
+    }
+
+    return changes;
+}
+
+} //end of namespace cpm
+
+#endif //CPM_CHANGEPOINT_HPP
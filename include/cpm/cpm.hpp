@@ -14,16 +14,32 @@
 #include <utility>
 #include <functional>
 #include <iomanip>
+#include <numeric>
+#include <regex>
+#include <cstdlib>
+#include <limits>
+#include <tuple>
+#include <map>
+#include <random>
+#include <memory>
 
 #include <sys/utsname.h>
 
 #include "compiler.hpp"
 #include "duration.hpp"
 #include "random.hpp"
+#include "workload.hpp"
 #include "policy.hpp"
+#include "runtime_policy.hpp"
 #include "io.hpp"
 #include "json.hpp"
+#include "binary.hpp"
+#include "store.hpp"
+#include "journal.hpp"
 #include "config.hpp"
+#include "environment.hpp"
+#include "noise.hpp"
+#include "repetition.hpp"
 
 namespace cpm {
 
@@ -79,6 +95,100 @@ inline std::vector<std::string> extract_tags(const std::string& title, bool stri
     return tags;
 }
 
+//A filter on the benches, by title, by tags or by regular expression on the title
+struct bench_filter {
+    std::string title;
+    std::vector<std::string> tags;
+    std::string pattern;
+    std::regex regex;
+
+    bool matches(const std::string& o_title, const std::vector<std::string>& o_tags) const {
+        //An empty filter selects everything
+        if(pattern.empty() && title.empty() && tags.empty()){
+            return true;
+        }
+
+        if(!pattern.empty()){
+            return std::regex_search(o_title, regex);
+        }
+
+        if(!title.empty()){
+            return o_title == title;
+        }
+
+        for(auto& tag : o_tags){
+            for(auto& filter_tag : tags){
+                if(tag == filter_tag){
+                    return true;
+                }
+            }
+        }
+
+        return false;
+    }
+
+    std::string description() const {
+        if(!pattern.empty()){
+            return "regex: " + pattern;
+        } else if(!title.empty()){
+            return "title: " + title;
+        } else if(tags.empty()){
+            return "nothing (all the benches)";
+        } else {
+            return "tags: " + std::accumulate(tags.begin(), tags.end(), std::string(), [](auto a, auto b){ return a + "[" + b + "]"; });
+        }
+    }
+};
+
+inline bench_filter make_filter(std::string filter){
+    bench_filter result;
+
+    trim(filter);
+
+    auto open = std::count(filter.begin(), filter.end(), '[');
+    auto close = std::count(filter.begin(), filter.end(), ']');
+    if(open == close && open > 0){
+        result.tags = extract_tags(filter, true);
+
+        //Fall back to title if not able to parse the tags
+        if(result.tags.empty()){
+            result.title = filter;
+        }
+    } else {
+        result.title = filter;
+    }
+
+    return result;
+}
+
+//Throws std::regex_error if the pattern is invalid
+inline bench_filter make_regex_filter(const std::string& pattern){
+    bench_filter result;
+    result.pattern = pattern;
+    result.regex = std::regex(pattern);
+    return result;
+}
+
+//Indicates if a bench must be run, i.e. if it matches one of the filters
+inline bool filters_match(const std::vector<bench_filter>& filters, std::string title){
+    if(filters.empty()){
+        return true;
+    }
+
+    trim(title);
+
+    auto tags = extract_tags(title, false);
+    auto title_only = tags.empty() ? title : extract_title(title);
+
+    for(auto& filter : filters){
+        if(filter.matches(title_only, tags)){
+            return true;
+        }
+    }
+
+    return false;
+}
+
 template<bool Sizes, typename Tuple, typename Functor, std::size_t... I, typename... Args, std::enable_if_t<Sizes, int> = 42>
 inline void call_with_data_final(Tuple& data, Functor& functor, std::index_sequence<I...> /*indices*/, Args... args){
     functor(args..., std::get<I>(data)...);
@@ -190,9 +300,9 @@ inline std::size_t mul_all() {
     return 1;
 }
 
-template <typename... T>
-inline std::size_t mul_all(std::size_t first, T... args) {
-    return first * mul_all(args...);
+template <typename H, typename... T>
+inline std::size_t mul_all(H first, T... args) {
+    return dimension_to_eff(first) * mul_all(args...);
 }
 
 inline std::size_t mul_all(std::size_t first) {
@@ -209,17 +319,25 @@ inline std::size_t mul_all(std::tuple<TT...> tuple) {
     return mul_all(tuple, std::make_index_sequence<sizeof...(TT)>());
 }
 
-template<typename DefaultPolicy = std_stop_policy>
+#ifndef CPM_DEFAULT_POLICY
+#define CPM_DEFAULT_POLICY cpm::std_stop_policy
+#endif
+
+template<typename DefaultPolicy = CPM_DEFAULT_POLICY>
 struct benchmark;
 
 struct section_data {
     std::string name;
+    std::size_t duration = 0; //ms
 
     //TODO This datastructure is probably not ideal
     std::vector<std::string> names;
     std::vector<std::string> sizes;
     std::vector<std::size_t> sizes_eff;
+    std::vector<std::string> regimes;
+    std::vector<std::vector<std::string>> coordinates;
     std::vector<std::vector<measure_result>> results;
+    std::vector<std::vector<std::vector<measure_result>>> repetitions; //The measures of each process, when the run was repeated
 
     section_data() = default;
     section_data(const section_data&) = default;
@@ -228,15 +346,33 @@ struct section_data {
     section_data& operator=(section_data&&) = default;
 };
 
+//Warmup and steps of a block of samples
+struct block_config {
+    std::size_t warmup;
+    std::size_t steps;
+};
+
 template<typename Bench, typename Policy, typename Flops>
 struct section {
 private:
+    using point_type = std::decay_t<decltype(Policy::begin())>;
+
     Bench& bench;
     Flops flops;
     bool enabled;
 
     section_data data;
 
+    //The sizes measured by the first implementation
+    std::vector<point_type> points;
+
+    //The implementations waiting to be measured interleaved
+    std::vector<std::pair<std::string, std::function<measure_result(const point_type&, const block_config&)>>> pending;
+
+    std::size_t block = 0;
+
+    timer_clock::time_point start_time = timer_clock::now();
+
 public:
     std::size_t warmup = 10;
     std::size_t steps = 50;
@@ -249,12 +385,49 @@ public:
         }
     }
 
+    /*
+     * Interleave the implementations measured from now on: their measures
+     * are delayed until the end of the section (or run_interleaved()) and
+     * each size is then measured in blocks of samples, alternating the
+     * implementations in a random order for each block (a rotating order
+     * without seed), so that a slow drift of the host does not favour any
+     * implementation. The sizes are chosen from the measures of the first
+     * implementation.
+     *
+     * The functors and the references are used after the measure functions
+     * return, the data they use must outlive the measures.
+     */
+    void interleave(std::size_t samples = 1){
+        block = samples;
+    }
+
+    //Measure the delayed implementations
+    void run_interleaved(){
+        if(pending.empty()){
+            return;
+        }
+
+        auto implementations = std::move(pending);
+        pending.clear();
+
+        auto tests = bench.tests;
+
+        run([&implementations, this](const point_type& sizes){
+            return this->measure_interleaved(implementations, sizes);
+        });
+
+        //Each implementation is a test, like when they are not interleaved
+        if(bench.tests > tests){
+            bench.tests += implementations.size() - 1;
+        }
+    }
+
     //Measure once functor (no policy, no randomization)
 
     template<typename Functor>
     void measure_once(const std::string& title, Functor functor){
         if(enabled){
-            auto duration = bench.measure_only_simple(*this, functor, flops);
+            auto duration = bench.journaled(data.name, title, "1", [&](){ return bench.measure_only_simple(*this, functor, flops); });
             report(title, std::size_t(1), duration);
         }
     }
@@ -263,10 +436,14 @@ public:
 
     template<typename Functor>
     void measure_simple(const std::string& title, Functor functor){
-        if(enabled){
-            bench.template policy_run<Policy>(
+        if(enabled && block){
+            pending.emplace_back(title, [functor, this](const point_type& sizes, const block_config& config){
+                return bench.measure_only_simple(config, functor, flops, sizes);
+            });
+        } else if(enabled){
+            run(
                 [&title, &functor, this](auto sizes){
-                    auto duration = bench.measure_only_simple(*this, functor, flops, sizes);
+                    auto duration = bench.journaled(data.name, title, size_to_string(sizes), [&](){ return bench.measure_only_simple(*this, functor, flops, sizes); });
                     this->report(title, sizes, duration);
                     return duration;
                 }
@@ -278,10 +455,14 @@ public:
 
     template<bool Sizes = true, typename Init, typename Functor>
     void measure_two_pass(const std::string& title, Init init, Functor functor){
-        if(enabled){
-            bench.template policy_run<Policy>(
+        if(enabled && block){
+            pending.emplace_back(title, [init, functor, this](const point_type& sizes, const block_config& config){
+                return bench.template measure_only_two_pass<Sizes>(config, init, functor, flops, sizes);
+            });
+        } else if(enabled){
+            run(
                 [&title, &functor, &init, this](auto sizes){
-                    auto duration = bench.template measure_only_two_pass<Sizes>(*this, init, functor, flops, sizes);
+                    auto duration = bench.journaled(data.name, title, size_to_string(sizes), [&](){ return bench.template measure_only_two_pass<Sizes>(*this, init, functor, flops, sizes); });
                     this->report(title, sizes, duration);
                     return duration;
                 }
@@ -293,10 +474,14 @@ public:
 
     template<typename Functor, typename... T>
     void measure_global(const std::string& title, Functor functor, T&... references){
-        if(enabled){
-            bench.template policy_run<Policy>(
+        if(enabled && block){
+            pending.emplace_back(title, [functor, &references..., this](const point_type& sizes, const block_config& config){
+                return bench.measure_only_global(config, functor, flops, sizes, references...);
+            });
+        } else if(enabled){
+            run(
                 [&title, &functor, &references..., this](auto sizes){
-                    auto duration = bench.measure_only_global(*this, functor, flops, sizes, references...);
+                    auto duration = bench.journaled(data.name, title, size_to_string(sizes), [&](){ return bench.measure_only_global(*this, functor, flops, sizes, references...); });
                     this->report(title, sizes, duration);
                     return duration;
                 }
@@ -305,6 +490,14 @@ public:
     }
 
     ~section(){
+        run_interleaved();
+
+        data.duration = std::chrono::duration_cast<millseconds>(timer_clock::now() - start_time).count();
+
+        if(detail::sorts_sizes<Policy>::value){
+            sort_sizes();
+        }
+
         if(bench.standard_report){
             if(data.names.empty()){
                 return;
@@ -398,27 +591,131 @@ public:
     }
 
 private:
+    template<typename M>
+    void run(M measure){
+        //Policies driving the measures choose the sizes from the measures,
+        //the next implementations are measured on the same sizes as the first
+        if(detail::has_custom_run<Policy>::value && !points.empty()){
+            ++bench.tests;
+
+            for(auto& d : points){
+                measure(d);
+            }
+        } else {
+            auto tags = extract_tags(data.name, false);
+            bench.template policy_run<Policy>(tags.empty() ? data.name : extract_title(data.name), measure);
+        }
+    }
+
+    //Measure all the implementations on the given sizes, returns the measure of the first one
+    template<typename Implementations>
+    measure_result measure_interleaved(Implementations& implementations, const point_type& sizes){
+        auto n = implementations.size();
+        auto size = size_to_string(sizes);
+
+        std::vector<measure_result> results(n);
+        std::vector<bool> done(n, false);
+
+        //The measures of the journal are not measured again
+        for(std::size_t i = 0; i < n; ++i){
+            auto it = bench.resumed.find(std::make_tuple(data.name, implementations[i].first, size));
+
+            if(it != bench.resumed.end()){
+                results[i] = it->second;
+                done[i] = true;
+            }
+        }
+
+        auto blocks = std::max<std::size_t>(1, steps / block);
+
+        std::vector<std::vector<measure_result>> parts(n);
+
+        std::vector<std::size_t> order(n);
+        std::iota(order.begin(), order.end(), 0);
+
+        for(std::size_t b = 0; b < blocks; ++b){
+            //The last block takes the remaining samples
+            block_config config{b ? std::min<std::size_t>(1, warmup) : warmup, b + 1 < blocks ? block : steps - b * block};
+
+            //The order is only random when the seed is recorded
+            if(bench.seed){
+                std::shuffle(order.begin(), order.end(), bench.order_generator);
+            } else if(b){
+                std::rotate(order.begin(), order.begin() + 1, order.end());
+            }
+
+            for(auto i : order){
+                if(!done[i]){
+                    parts[i].push_back(implementations[i].second(sizes, config));
+                }
+            }
+        }
+
+        for(std::size_t i = 0; i < n; ++i){
+            if(!done[i]){
+                bench.measures -= blocks - 1;
+                results[i] = bench.journaled(data.name, implementations[i].first, size, [&](){ return merge_results(parts[i]); });
+            }
+
+            report(implementations[i].first, sizes, results[i]);
+        }
+
+        return results.front();
+    }
+
+    void sort_sizes(){
+        std::vector<std::size_t> order(data.sizes.size());
+        std::iota(order.begin(), order.end(), 0);
+        std::stable_sort(order.begin(), order.end(), [this](std::size_t lhs, std::size_t rhs){ return data.sizes_eff[lhs] < data.sizes_eff[rhs]; });
+
+        auto permute = [&order](auto& values){
+            if(values.size() == order.size()){
+                std::remove_reference_t<decltype(values)> sorted;
+                for(auto i : order){
+                    sorted.push_back(values[i]);
+                }
+                values = std::move(sorted);
+            }
+        };
+
+        permute(data.sizes);
+        permute(data.sizes_eff);
+        permute(data.regimes);
+        permute(data.coordinates);
+
+        for(auto& results : data.results){
+            permute(results);
+        }
+    }
+
     template<typename Tuple>
     void report(const std::string& title, Tuple d, measure_result& duration){
-        if(data.names.empty() || data.names.back() != title){
+        //The interleaved implementations are reported size by size
+        auto index = std::find(data.names.begin(), data.names.end(), title) - data.names.begin();
+
+        if(std::size_t(index) == data.names.size()){
             data.names.push_back(title);
             data.results.emplace_back();
         }
 
-        if(data.names.size() == 1){
+        if(index == 0){
             data.sizes.push_back(size_to_string(d));
             data.sizes_eff.push_back(size_to_eff(d));
+            data.regimes.push_back(detail::size_regime<Policy>(d));
+            data.coordinates.push_back(size_to_coordinates(d));
+            points.push_back(d);
         }
 
         duration.update(size_to_eff(d));
 
-        data.results.back().push_back(duration);
+        data.results[index].push_back(duration);
     }
 };
 
 struct measure_data {
     std::string title;
     std::vector<measure_full> results;
+    std::size_t duration = 0; //ms
 };
 
 template<typename DefaultPolicy>
@@ -435,16 +732,31 @@ private:
     std::string configuration;
     std::string final_file;
     bool folder_ok = false;
+    bool default_tag = false;
+    bool store = false;
 
     std::string operating_system;
+    environment env;
     wall_time_point start_time;
 
     std::vector<measure_data> results;
     std::vector<section_data> section_results;
 
-    std::string filter;
-    std::string filter_title;
-    std::vector<std::string> filter_tags;
+    std::vector<bench_filter> filters;
+
+    journal results_journal;
+    std::vector<std::string> resumed_entries;
+    std::map<std::tuple<std::string, std::string, std::string>, measure_result> resumed;
+
+    noise_monitor monitor;
+    bool monitoring = false;
+    std::size_t noisy_samples = 0;
+    std::uint32_t noise_causes = 0;
+
+    std::uint32_t seed = 0;
+    std::mt19937 order_generator;
+
+    std::vector<repetition_layout> layouts; //The layouts of the processes, when the run was repeated
 
 public:
     std::size_t warmup = 10;
@@ -456,6 +768,17 @@ public:
 
     bool section_mflops = false;
 
+    std::string shard; //i/N when only a shard of the benches is run
+
+    bool auto_journal = true;
+
+    bool binary = false; //Save the results in the binary format (.cpmb)
+
+    bool monitor_noise = false; //Monitor the noise of the host during the measures
+    bool exclude_noisy = false; //Exclude the samples taken during disturbances
+
+    bool save_samples = false; //Save the durations of the samples of each point (JSON results only)
+
     benchmark(std::string name, std::string f = ".", std::string t = "", std::string c = "") : name(std::move(name)), folder(std::move(f)), tag(std::move(t)), configuration(std::move(c)) {
         //Get absolute cwd
         if(folder == "" || folder == "."){
@@ -492,6 +815,7 @@ public:
             auto f = get_free_file(folder);
             if(tag.empty()){
                 tag = f;
+                default_tag = true;
             }
             final_file = folder + f + ".cpm";
         }
@@ -509,54 +833,42 @@ public:
             operating_system = "unknown";
         }
 
+        //Capture the environment before the benchmarks load the host
+        env = capture_environment();
+
         //Store the time
         start_time = wall_clock::now();
     }
 
-    void set_filter(std::string filter){
-        this->filter = trim(filter);
+    //Randomize the orders of the measures with the given seed (not 0)
+    void set_seed(std::uint32_t value){
+        seed = value;
+        order_generator.seed(value);
+    }
 
-        auto open = std::count(filter.begin(), filter.end(), '[');
-        auto close = std::count(filter.begin(), filter.end(), ']');
-        if(open == close && open > 0){
-            this->filter_tags = extract_tags(filter, true);
+    //Append the results to the results store of the folder instead of a new file
+    void use_store(){
+        store = true;
 
-            //Fall back to title if not able to parse the tags
-            if(filter_tags.empty()){
-                this->filter_title = filter;
-            }
-        } else {
-            this->filter_title = filter;
+        //The runs are numbered in the store, the final number is assigned when the run is appended
+        if(default_tag && folder_ok){
+            tag = std::to_string(results_store(folder).index().size() + 1);
         }
-
-        auto_save = false;
     }
 
-    bool bench_should_run(std::string title){
-        if(filter_title.empty() && filter_tags.empty()){
-            return true;
-        }
-
-        trim(title);
-
-        auto tags = extract_tags(title, false);
-        auto title_only = tags.empty() ? title : extract_title(title);
+    void set_filter(std::string filter){
+        filters.clear();
+        add_filter(make_filter(std::move(filter)));
+    }
 
-        if(!filter_title.empty()){
-            return title_only == filter_title;
-        } else if(!filter_tags.empty()){
-            for(auto& tag : tags){
-                for(auto& filter_tag : filter_tags){
-                    if(tag == filter_tag){
-                        return true;
-                    }
-                }
-            }
+    void add_filter(bench_filter filter){
+        filters.push_back(std::move(filter));
 
-            return false;
-        }
+        auto_save = false;
+    }
 
-        return true;
+    bool bench_should_run(std::string title){
+        return filters_match(filters, std::move(title));
     }
 
     void begin(){
@@ -565,9 +877,9 @@ public:
             if(!folder_ok){
                 std::cout << "   Impossible to save the results (invalid folder)" << std::endl;
             } else if(auto_save){
-                std::cout << "   Results will be automatically saved in " << final_file << std::endl;
+                std::cout << "   Results will be automatically saved in " << result_file() << std::endl;
             } else {
-                std::cout << "   Results will be saved on-demand in " << final_file << std::endl;
+                std::cout << "   Results will be saved on-demand in " << result_file() << std::endl;
             }
 
 #ifdef CPM_AUTO_STEPS
@@ -584,21 +896,46 @@ public:
             std::cout << "   Configuration: " << configuration << std::endl;
             std::cout << "   Compiler: " << COMPILER_FULL << std::endl;
             std::cout << "   Operating System: " << operating_system << std::endl;
+            std::cout << "   CPU: " << env.cpu_model << " (" << env.sockets << " sockets, " << env.physical_cores << " cores, " << env.logical_cpus << " threads)" << std::endl;
+
+            if(!env.governor.empty()){
+                std::cout << "   Governor: " << env.governor << std::endl;
+            }
+
+            for(auto& filter : filters){
+                std::cout << "   Filter by " << filter.description() << std::endl;
+            }
+
+            if(!shard.empty()){
+                std::cout << "   Shard: " << shard << std::endl;
+            }
 
-            if(!filter_title.empty()){
-                std::cout << "   Filter by title: " << filter_title << std::endl;
+            if(seed){
+                std::cout << "   Seed: " << seed << std::endl;
             }
 
-            if(!filter_tags.empty()){
-                std::cout << "   Filter by tags: "
-                    << std::accumulate(filter_tags.begin(), filter_tags.end(), std::string(),
-                                       [](auto a, auto b){ return a + "[" + b + "]"; })
-                    << std::endl;
+            if(monitor_noise){
+                std::cout << "   Noise monitor: " << (exclude_noisy ? "samples taken during disturbances are excluded" : "samples taken during disturbances are flagged") << std::endl;
             }
 
+            if(!resumed.empty()){
+                std::cout << "   Resumed " << resumed.size() << " measures from " << journal_file() << std::endl;
+            } else if(folder_ok && access(journal_file().c_str(), F_OK) == 0){
+                std::cout << "   Warning: " << journal_file() << " is left by an interrupted run, it will be overwritten (see --resume)" << std::endl;
+            }
 
             std::cout << std::endl;
         }
+
+        //The noisy setups are reported even without the standard report
+        for(auto& warning : env.warnings()){
+            std::cout << "Warning: " << warning << std::endl;
+        }
+
+        if(monitor_noise && detail::monitor_cpu(sched_getcpu()) < 0){
+            std::cout << "Warning: The noise monitor needs a second CPU, it is disabled" << std::endl;
+            monitor_noise = false;
+        }
     }
 
     ~benchmark(){
@@ -612,6 +949,11 @@ public:
             std::cout << "   "  << tests << " tests have been run" << std::endl;
             std::cout << "   "  << measures << " measures have been taken" << std::endl;
             std::cout << "   "  << runs << " functors calls" << std::endl;
+
+            if(monitor_noise){
+                std::cout << "   "  << noisy_samples << " samples taken during disturbances" << (noise_causes ? " (" + noise_causes_str(noise_causes) + ")" : "") << std::endl;
+            }
+
             std::cout << std::endl;
         }
 
@@ -701,9 +1043,13 @@ public:
             measure_data data;
             data.title = title;
 
-            auto duration = measure_only_simple(*this, std::forward<Functor>(functor), std::forward<Flops>(flops));
+            auto start_time = timer_clock::now();
+
+            auto duration = journaled("", title, "1", [&](){ return measure_only_simple(*this, std::forward<Functor>(functor), std::forward<Flops>(flops)); });
             report(title, std::size_t(1), duration);
-            data.results.push_back({1, std::string("1"), duration});
+            data.results.push_back({1, std::string("1"), duration, std::string(), {}});
+
+            data.duration = std::chrono::duration_cast<millseconds>(timer_clock::now() - start_time).count();
 
             results.push_back(std::move(data));
         }
@@ -728,17 +1074,23 @@ public:
             measure_data data;
             data.title = title;
 
-            policy_run<Policy>(
+            auto start_time = timer_clock::now();
+
+            policy_run<Policy>(title,
                 [&data, &title, functor = std::forward<Functor>(functor), flops = std::forward<Flops>(flops), this](auto sizes){
                     using namespace cpm;
 
-                    auto duration = measure_only_simple(*this, functor, flops, sizes);
+                    auto duration = journaled("", title, size_to_string(sizes), [&](){ return measure_only_simple(*this, functor, flops, sizes); });
                     report(title, sizes, duration);
-                    data.results.push_back({size_to_eff(sizes), size_to_string(sizes), duration});
+                    data.results.push_back({size_to_eff(sizes), size_to_string(sizes), duration, detail::size_regime<Policy>(sizes), size_to_coordinates(sizes)});
                     return duration;
                 }
             );
 
+            sort_results<Policy>(data);
+
+            data.duration = std::chrono::duration_cast<millseconds>(timer_clock::now() - start_time).count();
+
             results.push_back(std::move(data));
         }
     }
@@ -762,17 +1114,23 @@ public:
             measure_data data;
             data.title = title;
 
-            policy_run<Policy>(
+            auto start_time = timer_clock::now();
+
+            policy_run<Policy>(title,
                 [&data, &title, functor = std::forward<Functor>(functor), init = std::forward<Init>(init), flops = std::forward<Flops>(flops), this](auto sizes){
                     using namespace cpm;
 
-                    auto duration = measure_only_two_pass<Sizes>(*this, init, functor, flops, sizes);
+                    auto duration = journaled("", title, size_to_string(sizes), [&](){ return measure_only_two_pass<Sizes>(*this, init, functor, flops, sizes); });
                     report(title, sizes, duration);
-                    data.results.push_back({size_to_eff(sizes), size_to_string(sizes), duration});
+                    data.results.push_back({size_to_eff(sizes), size_to_string(sizes), duration, detail::size_regime<Policy>(sizes), size_to_coordinates(sizes)});
                     return duration;
                 }
             );
 
+            sort_results<Policy>(data);
+
+            data.duration = std::chrono::duration_cast<millseconds>(timer_clock::now() - start_time).count();
+
             results.push_back(std::move(data));
         }
     }
@@ -796,17 +1154,23 @@ public:
             measure_data data;
             data.title = title;
 
-            policy_run<Policy>(
+            auto start_time = timer_clock::now();
+
+            policy_run<Policy>(title,
                 [&data, &title, functor = std::forward<Functor>(functor), flops = std::forward<Flops>(flops), &references..., this](auto sizes){
                     using namespace cpm;
 
-                    auto duration = measure_only_global(*this, functor, flops, sizes, references...);
+                    auto duration = journaled("", title, size_to_string(sizes), [&](){ return measure_only_global(*this, functor, flops, sizes, references...); });
                     report(title, sizes, duration);
-                    data.results.push_back({size_to_eff(sizes), size_to_string(sizes), duration});
+                    data.results.push_back({size_to_eff(sizes), size_to_string(sizes), duration, detail::size_regime<Policy>(sizes), size_to_coordinates(sizes)});
                     return duration;
                 }
             );
 
+            sort_results<Policy>(data);
+
+            data.duration = std::chrono::duration_cast<millseconds>(timer_clock::now() - start_time).count();
+
             results.push_back(std::move(data));
         }
     }
@@ -841,110 +1205,500 @@ private:
             time_str.pop_back();
         }
 
+        //The tag of a run of the store may change when it is appended
+        auto journal_path = journal_file();
+
+        bool saved = store ? save_store(time_str) : binary ? save_binary(time_str) : save_json(time_str);
+
+        //The journal is now saved in the results
+        if(saved){
+            results_journal.close();
+            unlink(journal_path.c_str());
+        }
+    }
+
+    bool save_json(const std::string& time_str){
         std::ofstream stream(final_file);
 
-        stream << "{\n";
+        json_writer writer(stream);
+
+        writer.start_sub();
 
-        std::size_t indent = 2;
+        writer.value("name", name);
+        writer.value("tag", tag);
+        writer.value("configuration", configuration);
+        writer.value("compiler", COMPILER_FULL);
+        writer.value("os", operating_system);
 
-        write_value(stream, indent, "name", name);
-        write_value(stream, indent, "tag", tag);
-        write_value(stream, indent, "configuration", configuration);
-        write_value(stream, indent, "compiler", COMPILER_FULL);
-        write_value(stream, indent, "os", operating_system);
+        writer.start_object("environment");
+        env.write(writer);
+        writer.close_sub(true);
 
-        write_value(stream, indent, "time", time_str);
-        write_value(stream, indent, "timestamp", std::chrono::duration_cast<seconds>(start_time.time_since_epoch()).count());
+        if(!shard.empty()){
+            writer.value("shard", shard);
+        }
+
+        if(seed){
+            writer.value("seed", seed);
+        }
 
-        start_array(stream, indent, "results");
+        if(!layouts.empty()){
+            writer.start_array("layouts");
+
+            for(std::size_t i = 0; i < layouts.size(); ++i){
+                writer.start_sub();
+                writer.value("env_padding", layouts[i].env_padding);
+                writer.value("stack_offset", layouts[i].stack_offset);
+                writer.value("heap_offset", layouts[i].heap_offset, false);
+                writer.close_sub(i < layouts.size() - 1);
+            }
+
+            writer.close_array(true);
+        }
+
+        writer.value("time", time_str);
+        writer.value("timestamp", std::chrono::duration_cast<seconds>(start_time.time_since_epoch()).count());
+
+        writer.start_array("results");
 
         for(std::size_t i = 0; i < results.size(); ++i){
             auto& result = results[i];
 
-            start_sub(stream, indent);
+            writer.start_sub();
 
-            write_value(stream, indent, "title", result.title);
-            start_array(stream, indent, "results");
+            writer.value("title", result.title);
+            writer.value("duration", result.duration);
+            writer.start_array("results");
 
             for(std::size_t j = 0; j < result.results.size(); ++j){
                 auto& sub = result.results[j];
 
-                start_sub(stream, indent);
-
-                write_value(stream, indent, "size", sub.size);
-                write_value(stream, indent, "size_eff", sub.size_eff);
-                write_value(stream, indent, "mean", sub.result.mean);
-                write_value(stream, indent, "mean_lb", sub.result.mean_lb);
-                write_value(stream, indent, "mean_ub", sub.result.mean_ub);
-                write_value(stream, indent, "stddev", sub.result.stddev);
-                write_value(stream, indent, "min", sub.result.min);
-                write_value(stream, indent, "max", sub.result.max);
-                write_value(stream, indent, "throughput", sub.result.throughput_e);
-                write_value(stream, indent, "throughput_e", sub.result.throughput_e);
-                write_value(stream, indent, "throughput_f", sub.result.throughput_f, false);
-
-                close_sub(stream, indent, j < result.results.size() - 1);
+                writer.start_sub();
+
+                writer.value("size", sub.size);
+                writer.value("size_eff", sub.size_eff);
+
+                if(!sub.regime.empty()){
+                    writer.value("regime", sub.regime);
+                }
+
+                if(!sub.coordinates.empty()){
+                    writer.raw_array("coordinates", sub.coordinates);
+                }
+
+                writer.value("mean", sub.result.mean);
+                writer.value("mean_lb", sub.result.mean_lb);
+                writer.value("mean_ub", sub.result.mean_ub);
+                writer.value("stddev", sub.result.stddev);
+                writer.value("min", sub.result.min);
+                writer.value("max", sub.result.max);
+                writer.value("flops", sub.result.flops);
+
+                if(sub.result.noise >= 0.0){
+                    writer.value("noise", sub.result.noise);
+                }
+
+                write_repetitions(writer, sub.repetitions);
+
+                if(!sub.result.durations.empty()){
+                    writer.array("samples", sub.result.durations);
+                }
+
+                writer.value("throughput", sub.result.throughput_e);
+                writer.value("throughput_e", sub.result.throughput_e);
+                writer.value("throughput_f", sub.result.throughput_f, false);
+
+                writer.close_sub(j < result.results.size() - 1);
             }
 
-            close_array(stream, indent, false);
-            close_sub(stream, indent, i < results.size() - 1);
+            writer.close_array(false);
+            writer.close_sub(i < results.size() - 1);
         }
 
-        close_array(stream, indent, true);
+        writer.close_array(true);
 
-        start_array(stream, indent, "sections");
+        writer.start_array("sections");
 
         for(std::size_t i = 0; i < section_results.size(); ++i){
             auto& section = section_results[i];
 
-            start_sub(stream, indent);
+            writer.start_sub();
 
-            write_value(stream, indent, "name", section.name);
-            start_array(stream, indent, "results");
+            writer.value("name", section.name);
+            writer.value("duration", section.duration);
+            writer.start_array("results");
 
             for(std::size_t j = 0; j < section.names.size(); ++j){
                 auto& name = section.names[j];
 
-                start_sub(stream, indent);
+                writer.start_sub();
 
-                write_value(stream, indent, "name", name);
-                start_array(stream, indent, "results");
+                writer.value("name", name);
+                writer.start_array("results");
 
                 for(std::size_t k = 0; k < section.results[j].size(); ++k){
-                    start_sub(stream, indent);
-
-                    write_value(stream, indent, "size", section.sizes[k]);
-                    write_value(stream, indent, "size_eff", section.sizes_eff[k]);
-                    write_value(stream, indent, "mean", section.results[j][k].mean);
-                    write_value(stream, indent, "mean_lb", section.results[j][k].mean_lb);
-                    write_value(stream, indent, "mean_ub", section.results[j][k].mean_ub);
-                    write_value(stream, indent, "stddev", section.results[j][k].stddev);
-                    write_value(stream, indent, "min", section.results[j][k].min);
-                    write_value(stream, indent, "max", section.results[j][k].max);
-                    write_value(stream, indent, "throughput", section.results[j][k].throughput_e);
-                    write_value(stream, indent, "throughput_e", section.results[j][k].throughput_e);
-                    write_value(stream, indent, "throughput_f", section.results[j][k].throughput_f, false);
-
-                    close_sub(stream, indent, k < section.results[j].size() - 1);
+                    writer.start_sub();
+
+                    writer.value("size", section.sizes[k]);
+                    writer.value("size_eff", section.sizes_eff[k]);
+
+                    if(!section.regimes[k].empty()){
+                        writer.value("regime", section.regimes[k]);
+                    }
+
+                    if(!section.coordinates[k].empty()){
+                        writer.raw_array("coordinates", section.coordinates[k]);
+                    }
+
+                    writer.value("mean", section.results[j][k].mean);
+                    writer.value("mean_lb", section.results[j][k].mean_lb);
+                    writer.value("mean_ub", section.results[j][k].mean_ub);
+                    writer.value("stddev", section.results[j][k].stddev);
+                    writer.value("min", section.results[j][k].min);
+                    writer.value("max", section.results[j][k].max);
+                    writer.value("flops", section.results[j][k].flops);
+
+                    if(section.results[j][k].noise >= 0.0){
+                        writer.value("noise", section.results[j][k].noise);
+                    }
+
+                    if(j < section.repetitions.size()){
+                        write_repetitions(writer, section.repetitions[j][k]);
+                    }
+
+                    if(!section.results[j][k].durations.empty()){
+                        writer.array("samples", section.results[j][k].durations);
+                    }
+
+                    writer.value("throughput", section.results[j][k].throughput_e);
+                    writer.value("throughput_e", section.results[j][k].throughput_e);
+                    writer.value("throughput_f", section.results[j][k].throughput_f, false);
+
+                    writer.close_sub(k < section.results[j].size() - 1);
                 }
 
-                close_array(stream, indent, false);
-                close_sub(stream, indent, j < section.names.size() - 1);
+                writer.close_array(false);
+                writer.close_sub(j < section.names.size() - 1);
             }
 
-            close_array(stream, indent, false);
-            close_sub(stream, indent, i < section_results.size() - 1);
+            writer.close_array(false);
+            writer.close_sub(i < section_results.size() - 1);
         }
 
-        close_array(stream, indent, false);
+        writer.close_array(false);
+        writer.close_sub(false);
+        writer.flush();
 
-        stream << "}";
+        stream.close();
+
+        return static_cast<bool>(stream);
     }
 
-    template<typename Policy, typename M>
-    void policy_run(M measure){
+    //The measures of each process of a point and the decomposition of its variance
+    static void write_repetitions(json_writer& writer, const std::vector<measure_result>& repetitions){
+        if(repetitions.empty()){
+            return;
+        }
+
+        writer.start_array("repetitions");
+
+        for(std::size_t i = 0; i < repetitions.size(); ++i){
+            writer.start_sub();
+            writer.value("mean", repetitions[i].mean);
+            writer.value("stddev", repetitions[i].stddev, false);
+            writer.close_sub(i < repetitions.size() - 1);
+        }
+
+        writer.close_array(true);
+
+        auto components = decompose_variance(repetitions);
+
+        writer.value("within_variance", components.within);
+        writer.value("between_variance", components.between);
+    }
+
+    bool save_binary(const std::string& time_str){
+        binary_writer writer;
+        binary_record(writer, time_str);
+        return writer.write(result_file());
+    }
+
+    bool save_store(const std::string& time_str){
+        store_entry entry;
+        entry.timestamp     = std::chrono::duration_cast<seconds>(start_time.time_since_epoch()).count();
+        entry.name          = name;
+        entry.compiler      = COMPILER_FULL;
+        entry.configuration = configuration;
+
+        //Another run may have been appended since the start
+        return results_store(folder).append([this, &time_str](std::size_t number, store_entry& record_entry){
+            if(default_tag){
+                tag = std::to_string(number);
+            }
+
+            record_entry.tag = tag;
+
+            binary_writer writer;
+            binary_record(writer, time_str);
+
+            std::ostringstream record;
+            writer.write(record);
+
+            return record.str();
+        }, entry);
+    }
+
+    void binary_record(binary_writer& writer, const std::string& time_str){
+        writer.run(name, tag, configuration, COMPILER_FULL, operating_system, time_str,
+            std::chrono::duration_cast<seconds>(start_time.time_since_epoch()).count(), shard);
+
+        writer.environment(env.json());
+        writer.seed(seed);
+
+        auto coordinates = [](const std::vector<std::string>& values){
+            if(values.empty()){
+                return std::string();
+            }
+
+            std::string array = "[";
+            for(std::size_t i = 0; i < values.size(); ++i){
+                array += (i ? ", " : "") + values[i];
+            }
+            return array + "]";
+        };
+
+        for(auto& result : results){
+            writer.start_series("", result.title, result.duration);
+
+            for(auto& sub : result.results){
+                writer.point(sub.size, sub.size_eff, sub.regime, coordinates(sub.coordinates), sub.result);
+            }
+        }
+
+        for(auto& section : section_results){
+            for(std::size_t j = 0; j < section.names.size(); ++j){
+                writer.start_series(section.name, section.names[j], section.duration);
+
+                for(std::size_t k = 0; k < section.results[j].size(); ++k){
+                    writer.point(section.sizes[k], section.sizes_eff[k], section.regimes[k], coordinates(section.coordinates[k]), section.results[j][k]);
+                }
+            }
+        }
+    }
+
+public:
+    std::string journal_file() const {
+        return store ? folder + "store-" + tag + ".journal" : final_file + ".journal";
+    }
+
+    std::string result_file() const {
+        return store ? results_store(folder).data_file() : binary ? final_file + "b" : final_file;
+    }
+
+    /*
+     * Replace the results by the combination of the results of the
+     * repetitions of the run, saved in binary by each process. The benches
+     * and sections are in the order of the first repetition.
+     */
+    bool merge_repetitions(const std::vector<std::string>& files, std::vector<repetition_layout> repetition_layouts){
+        std::vector<std::unique_ptr<binary_file>> runs;
+
+        for(auto& file : files){
+            runs.push_back(std::make_unique<binary_file>());
+
+            if(!runs.back()->open(file)){
+                return false;
+            }
+        }
+
+        auto section_of = [](const binary_file& run, const binary_series& series){
+            return std::string(series.section == binary_none ? "" : run.string(series.section));
+        };
+
+        //The coordinates are stored as a JSON array
+        auto split_coordinates = [](std::string array){
+            std::vector<std::string> values;
+
+            if(array.size() > 2){
+                std::istringstream stream(array.substr(1, array.size() - 2));
+                std::string value;
+
+                while(std::getline(stream, value, ',')){
+                    auto begin = value.find_first_not_of(' ');
+                    values.push_back(begin == std::string::npos ? "" : value.substr(begin));
+                }
+            }
+
+            return values;
+        };
+
+        results.clear();
+        section_results.clear();
+
+        auto& first = *runs.front();
+
+        for(std::size_t i = 0; i < first.header().n_series; ++i){
+            auto& series = first.series()[i];
+
+            auto section = section_of(first, series);
+            std::string title = first.string(series.title);
+
+            std::vector<measure_result> combined;
+            std::vector<std::vector<measure_result>> repetitions(series.count);
+
+            double duration = 0.0;
+
+            for(auto& run : runs){
+                for(std::size_t s = 0; s < run->header().n_series; ++s){
+                    auto& other = run->series()[s];
+
+                    if(section_of(*run, other) != section || title != run->string(other.title)){
+                        continue;
+                    }
+
+                    duration += other.duration;
+
+                    //The sizes measured depend on the policy, a size may be missing in some processes
+                    for(std::size_t j = 0; j < series.count; ++j){
+                        for(std::size_t k = other.first; k < other.first + other.count; ++k){
+                            if(!std::strcmp(run->string(run->sizes()[k]), first.string(first.sizes()[series.first + j]))){
+                                repetitions[j].push_back(run->result(k));
+                                break;
+                            }
+                        }
+                    }
+
+                    break;
+                }
+            }
+
+            for(std::size_t j = 0; j < series.count; ++j){
+                combined.push_back(combine_repetitions(repetitions[j], first.size_eff()[series.first + j]));
+            }
+
+            auto point_string = [&first](const std::uint32_t* column, std::size_t j){
+                return std::string(column[j] == binary_none ? "" : first.string(column[j]));
+            };
+
+            if(section.empty()){
+                measure_data data;
+                data.title = title;
+                data.duration = duration / runs.size();
+
+                for(std::size_t j = 0; j < series.count; ++j){
+                    auto p = series.first + j;
+                    data.results.push_back({first.size_eff()[p], first.string(first.sizes()[p]), combined[j], point_string(first.regimes(), p),
+                        split_coordinates(point_string(first.coordinates(), p)), repetitions[j]});
+                }
+
+                results.push_back(std::move(data));
+            } else {
+                auto it = std::find_if(section_results.begin(), section_results.end(), [&section](const section_data& data){ return data.name == section; });
+
+                if(it == section_results.end()){
+                    section_results.emplace_back();
+                    it = section_results.end() - 1;
+                    it->name = section;
+                    it->duration = duration / runs.size();
+
+                    for(std::size_t j = 0; j < series.count; ++j){
+                        auto p = series.first + j;
+                        it->sizes.push_back(first.string(first.sizes()[p]));
+                        it->sizes_eff.push_back(first.size_eff()[p]);
+                        it->regimes.push_back(point_string(first.regimes(), p));
+                        it->coordinates.push_back(split_coordinates(point_string(first.coordinates(), p)));
+                    }
+                }
+
+                it->names.push_back(title);
+                it->results.push_back(std::move(combined));
+                it->repetitions.push_back(std::move(repetitions));
+            }
+        }
+
+        layouts = std::move(repetition_layouts);
+
+        return true;
+    }
+
+    //Reuse the measures of the journal left by an interrupted run
+    std::size_t resume(){
+        resumed_entries = journal::read(journal_file());
+
+        for(auto& entry : resumed_entries){
+            std::map<std::string, std::string> values;
+            detail::parse_journal_line(entry, values);
+
+            measure_result result;
+            result.mean = std::atof(values["mean"].c_str());
+            result.mean_lb = std::atof(values["mean_lb"].c_str());
+            result.mean_ub = std::atof(values["mean_ub"].c_str());
+            result.stddev = std::atof(values["stddev"].c_str());
+            result.min = std::atof(values["min"].c_str());
+            result.max = std::atof(values["max"].c_str());
+            result.throughput_e = std::atof(values["throughput_e"].c_str());
+            result.throughput_f = std::atof(values["throughput_f"].c_str());
+            result.flops = std::strtoull(values["flops"].c_str(), nullptr, 10);
+            result.noise = values.count("noise") ? std::atof(values["noise"].c_str()) : -1.0;
+
+            resumed[std::make_tuple(values["section"], values["title"], values["size"])] = result;
+        }
+
+        return resumed.size();
+    }
+
+private:
+    //Measure unless the measure is in the resumed journal, the new
+    //measures are appended to the journal
+    template<typename Measure>
+    measure_result journaled(const std::string& section, const std::string& title, const std::string& size, Measure measure){
+        auto it = resumed.find(std::make_tuple(section, title, size));
+        if(it != resumed.end()){
+            return it->second;
+        }
+
+        auto duration = measure();
+
+        if(!results_journal.is_open() && auto_journal && auto_save && folder_ok){
+            results_journal.open(journal_file(), resumed_entries);
+        }
+
+        std::ostringstream entry;
+        entry << std::setprecision(std::numeric_limits<double>::max_digits10);
+        entry << "{\"section\": \"" << json_escape(section) << "\", \"title\": \"" << json_escape(title) << "\", \"size\": \"" << json_escape(size) << "\""
+              << ", \"mean\": " << duration.mean << ", \"mean_lb\": " << duration.mean_lb << ", \"mean_ub\": " << duration.mean_ub
+              << ", \"stddev\": " << duration.stddev << ", \"min\": " << duration.min << ", \"max\": " << duration.max
+              << ", \"throughput_e\": " << duration.throughput_e << ", \"throughput_f\": " << duration.throughput_f
+              << ", \"flops\": " << duration.flops << ", \"noise\": " << duration.noise << "}";
+
+        results_journal.append(entry.str());
+
+        return duration;
+    }
+
+    template<typename Policy>
+    void sort_results(measure_data& data){
+        if(detail::sorts_sizes<Policy>::value){
+            std::stable_sort(data.results.begin(), data.results.end(),
+                [](const measure_full& lhs, const measure_full& rhs){ return lhs.size_eff < rhs.size_eff; });
+        }
+    }
+
+    template<typename Policy, typename M, std::enable_if_t<detail::has_custom_run<Policy>::value, int> = 42>
+    void policy_run(const std::string& title, M measure){
+        ++tests;
+
+        detail::select_title<Policy>(title);
+
+        Policy::run(measure);
+    }
+
+    template<typename Policy, typename M, std::enable_if_t<!detail::has_custom_run<Policy>::value, int> = 42>
+    void policy_run(const std::string& title, M measure){
         ++tests;
 
+        detail::select_title<Policy>(title);
+
         std::size_t i = 0;
         auto d = Policy::begin();
         auto duration = measure(d);
@@ -986,7 +1740,50 @@ private:
         double mean_lb = mean - 1.96 * stderror;
         double mean_ub = mean + 1.96 * stderror;
 
-        return {mean, mean_lb, mean_ub, stddev, min, max, 0.0, 0.0, flops};
+        measure_result result{mean, mean_lb, mean_ub, stddev, min, max, 0.0, 0.0, flops};
+        result.samples = n;
+
+        if(save_samples){
+            result.durations.assign(durations.begin(), durations.end());
+        }
+
+        return result;
+    }
+
+    void start_monitor(){
+        monitoring = monitor_noise && monitor.start();
+    }
+
+    //Measure the samples of a monitored window, the samples taken during disturbances are excluded if exclude_noisy
+    measure_result measure(const std::vector<std::size_t>& durations, const std::vector<timer_clock::time_point>& starts, std::size_t flops){
+        if(!monitoring){
+            return measure(durations, flops);
+        }
+
+        monitor.stop();
+        monitoring = false;
+
+        auto flags = monitor.disturbed(starts, durations);
+
+        std::vector<std::size_t> clean;
+        for(std::size_t i = 0; i < durations.size(); ++i){
+            if(!flags[i]){
+                clean.push_back(durations[i]);
+            }
+        }
+
+        auto disturbed = durations.size() - clean.size();
+
+        noisy_samples += disturbed;
+        noise_causes |= monitor.causes();
+
+        if(exclude_noisy && clean.empty() && standard_report){
+            std::cout << "   Warning: all the samples were taken during disturbances (" << noise_causes_str(monitor.causes()) << "), none is excluded" << std::endl;
+        }
+
+        auto result = measure(exclude_noisy && !clean.empty() ? clean : durations, flops);
+        result.noise = double(disturbed) / durations.size();
+        return result;
     }
 
     template<typename Config, typename Functor, typename Flops, typename... Args>
@@ -1034,6 +1831,9 @@ private:
 #endif
 
         std::vector<std::size_t> durations(steps);
+        std::vector<timer_clock::time_point> starts(steps);
+
+        start_monitor();
 
         std::size_t i = 0;
 
@@ -1043,6 +1843,7 @@ private:
             auto end_time = timer_clock::now();
             auto duration = std::chrono::duration_cast<clock_resolution>(end_time - start_time);
             durations[i] = duration.count();
+            starts[i] = start_time;
         }
 
         auto start_time = timer_clock::now();
@@ -1051,10 +1852,11 @@ private:
         auto end_time = timer_clock::now();
         auto duration = std::chrono::duration_cast<clock_resolution>(end_time - start_time);
         durations[i] = duration.count();
+        starts[i] = start_time;
 
         runs += steps;
 
-        return measure(durations, call_flops(flops, args...));
+        return measure(durations, starts, call_flops(flops, args...));
     }
 
     template<bool Sizes, typename Config, typename Init, typename Functor, typename Flops, typename... Args>
@@ -1116,6 +1918,9 @@ private:
         random_init_each(data, sequence);
 
         std::vector<std::size_t> durations(steps);
+        std::vector<timer_clock::time_point> starts(steps);
+
+        start_monitor();
 
         std::size_t i = 0;
 
@@ -1126,6 +1931,7 @@ private:
             auto end_time = timer_clock::now();
             auto duration = std::chrono::duration_cast<clock_resolution>(end_time - start_time);
             durations[i] = duration.count();
+            starts[i] = start_time;
         }
 
         randomize_each(data, sequence);
@@ -1135,10 +1941,11 @@ private:
         auto end_time = timer_clock::now();
         auto duration = std::chrono::duration_cast<clock_resolution>(end_time - start_time);
         durations[i] = duration.count();
+        starts[i] = start_time;
 
         runs += steps;
 
-        return measure(durations, call_flops(flops, args...));
+        return measure(durations, starts, call_flops(flops, args...));
     }
 
     template<typename Config, typename Functor, typename Flops, typename Tuple, typename... T>
@@ -1196,10 +2003,13 @@ private:
         random_init(references...);
 
         std::vector<std::size_t> durations(steps);
+        std::vector<timer_clock::time_point> starts(steps);
+
+        start_monitor();
 
         std::size_t i = 0;
 
-        for(; i < steps; ++i){
+        for(; i < steps - 1; ++i){
             using cpm::randomize;
             randomize(references...);
             auto start_time = timer_clock::now();
@@ -1207,6 +2017,7 @@ private:
             auto end_time = timer_clock::now();
             auto duration = std::chrono::duration_cast<clock_resolution>(end_time - start_time);
             durations[i] = duration.count();
+            starts[i] = start_time;
         }
 
         using cpm::randomize;
@@ -1217,10 +2028,11 @@ private:
         auto end_time = timer_clock::now();
         auto duration = std::chrono::duration_cast<clock_resolution>(end_time - start_time);
         durations[i] = duration.count();
+        starts[i] = start_time;
 
         runs += steps;
 
-        return measure(durations, call_flops(flops, d));
+        return measure(durations, starts, call_flops(flops, d));
     }
 
     template<typename Tuple>
@@ -1235,8 +2047,13 @@ private:
                 << " min:" << duration_str(duration.min, 3)
                 << " max:" << duration_str(duration.max, 3)
                 << " (" << throughput_str(duration.throughput_e, 3) << "Es"
-                << "," << throughput_str(duration.throughput_f, 3) << "Flop/s)"
-                << "\n";
+                << "," << throughput_str(duration.throughput_f, 3) << "Flop/s)";
+
+            if(duration.noise >= 0.0){
+                std::cout << " noise:" << to_string_precision(100.0 * duration.noise, 3) << "%";
+            }
+
+            std::cout << "\n";
         }
     }
 };
@@ -8,21 +8,114 @@
 #ifndef CPM_CPM_SUPPORT_HPP
 #define CPM_CPM_SUPPORT_HPP
 
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+
+#include <alloca.h>
+
 #include "../../lib/cxxopts/src/cxxopts.hpp"
 
 namespace cpm {
 
+struct registered_bench {
+    void (*function)(cpm::benchmark<>&);
+    std::vector<std::string> titles; //The titles measured by the function, empty if unknown
+    const char* file;
+    std::size_t line;
+
+    //Indicates if the function needs to be called for the given filters
+    bool should_run(const std::vector<bench_filter>& filters) const {
+        if(titles.empty()){
+            return true;
+        }
+
+        for(auto& title : titles){
+            if(filters_match(filters, title)){
+                return true;
+            }
+        }
+
+        return false;
+    }
+};
+
 struct cpm_registry {
-    cpm_registry(void (*function)(cpm::benchmark<>&)){
-        benchs().emplace_back(function);
+    cpm_registry(void (*function)(cpm::benchmark<>&), const char* file, std::size_t line, std::vector<std::string> titles = {}){
+        benchs().push_back({function, std::move(titles), file, line});
     }
 
-    static std::vector<void(*)(cpm::benchmark<>&)>& benchs(){
-        static std::vector<void(*)(cpm::benchmark<>&)> vec;
+    static std::vector<registered_bench>& benchs(){
+        static std::vector<registered_bench> vec;
         return vec;
     }
 };
 
+//Read the duration of each bench and section of a binary result file, the
+//JSON results can be converted with cpm convert
+inline bool read_bench_durations(const std::string& file, std::map<std::string, double>& durations){
+    cpm::binary_file binary;
+
+    if(!cpm::binary_file::is_binary(file) || !binary.open(file)){
+        return false;
+    }
+
+    for(std::size_t i = 0; i < binary.header().n_series; ++i){
+        auto& series = binary.series()[i];
+        durations[binary.string(series.section == cpm::binary_none ? series.title : series.section)] = series.duration;
+    }
+
+    return true;
+}
+
+//Assign the registered benches to n shards. The benches are assigned in
+//decreasing order of duration, each to the least loaded shard. Benches
+//without a known duration count as the average known duration.
+inline std::vector<std::size_t> shard_benchs(const std::vector<registered_bench>& benchs, const std::map<std::string, double>& durations, std::size_t n){
+    std::vector<double> weights(benchs.size(), 0.0);
+    std::vector<bool> known(benchs.size(), false);
+
+    double total = 0.0;
+    std::size_t count = 0;
+
+    for(std::size_t i = 0; i < benchs.size(); ++i){
+        for(auto& title : benchs[i].titles){
+            auto clean = extract_tags(title, false).empty() ? title : extract_title(title);
+            auto it = durations.find(clean);
+            if(it != durations.end()){
+                weights[i] += it->second;
+                known[i] = true;
+            }
+        }
+
+        if(known[i]){
+            total += weights[i];
+            ++count;
+        }
+    }
+
+    for(std::size_t i = 0; i < benchs.size(); ++i){
+        if(!known[i]){
+            weights[i] = count ? total / count : 1.0;
+        }
+    }
+
+    std::vector<std::size_t> order(benchs.size());
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&weights](std::size_t lhs, std::size_t rhs){ return weights[lhs] > weights[rhs]; });
+
+    std::vector<double> loads(n, 0.0);
+    std::vector<std::size_t> shards(benchs.size(), 0);
+
+    for(auto i : order){
+        auto shard = std::min_element(loads.begin(), loads.end()) - loads.begin();
+        shards[i] = shard;
+        loads[shard] += weights[i];
+    }
+
+    return shards;
+}
+
 template<template<typename...> class TT, typename T>
 struct is_specialization_of : std::false_type {};
 
@@ -40,30 +133,41 @@ struct is_section : is_specialization_of<cpm::section, std::decay_t<T>> {};
 #define CPM_UNIQUE(x, y) CPM_UNIQUE_DETAIL(x, y)
 #define CPM_UNIQUE_NAME(x) CPM_UNIQUE(x, __LINE__)
 
+#define CPM_FIRST_DETAIL(first, ...) first
+#define CPM_FIRST(...) CPM_FIRST_DETAIL(__VA_ARGS__, 0)
+
 //Declarations of benchs functions
 
 #define CPM_BENCH()  \
     static void CPM_UNIQUE_NAME(bench_) (cpm::benchmark<>& bench); \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(bench_)); }              \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(bench_), __FILE__, __LINE__); }              \
+    static void CPM_UNIQUE_NAME(bench_) (cpm::benchmark<>& bench)
+
+//Declaration of bench functions with the titles they measure, skipped
+//entirely when none of the titles is selected by the filters
+
+#define CPM_NAMED_BENCH(...)  \
+    static void CPM_UNIQUE_NAME(bench_) (cpm::benchmark<>& bench); \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(bench_), __FILE__, __LINE__, {__VA_ARGS__}); }              \
     static void CPM_UNIQUE_NAME(bench_) (cpm::benchmark<>& bench)
 
 //Declaration of section functions
 
 #define CPM_SECTION(name)\
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master);      \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_)); }        \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_), __FILE__, __LINE__, {name}); }        \
     void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master) {     \
     auto bench = master.multi(name);
 
 #define CPM_SECTION_F(name, ...)\
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master);      \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_)); }        \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_), __FILE__, __LINE__, {name}); }        \
     void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master) {     \
     auto bench = master.multi(name, __VA_ARGS__);
 
 #define CPM_SECTION_O(name, W, R)\
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master);      \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_)); }        \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_), __FILE__, __LINE__, {name}); }        \
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master) {     \
     auto bench = master.multi(name);    \
     bench.warmup = W;                   \
@@ -71,7 +175,7 @@ struct is_section : is_specialization_of<cpm::section, std::decay_t<T>> {};
 
 #define CPM_SECTION_OF(name, W, R, ...)\
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master);      \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_)); }        \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_), __FILE__, __LINE__, {name}); }        \
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master) {     \
     auto bench = master.multi(name, __VA_ARGS__);    \
     bench.warmup = W;                   \
@@ -79,19 +183,19 @@ struct is_section : is_specialization_of<cpm::section, std::decay_t<T>> {};
 
 #define CPM_SECTION_P(name, policy)\
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master);      \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_)); }        \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_), __FILE__, __LINE__, {name}); }        \
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master) {     \
     auto bench = master.multi<policy>(name);
 
 #define CPM_SECTION_PF(name, policy, ...)\
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master);      \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_)); }        \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_), __FILE__, __LINE__, {name}); }        \
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master) {     \
     auto bench = master.multi<policy>(name, __VA_ARGS__);
 
 #define CPM_SECTION_PO(name, policy, W, R)\
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master);      \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_)); }        \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_), __FILE__, __LINE__, {name}); }        \
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master) {     \
     auto bench = master.multi<policy>(name);      \
     bench.warmup = W;                             \
@@ -99,7 +203,7 @@ struct is_section : is_specialization_of<cpm::section, std::decay_t<T>> {};
 
 #define CPM_SECTION_POF(name, policy, W, R, ...)\
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master);      \
-    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_)); }        \
+    namespace { cpm::cpm_registry CPM_UNIQUE_NAME(register_) (& CPM_UNIQUE_NAME(section_), __FILE__, __LINE__, {name}); }        \
     static void CPM_UNIQUE_NAME(section_) (cpm::benchmark<>& master) {     \
     auto bench = master.multi<policy>(name, __VA_ARGS__);      \
     bench.warmup = W;                             \
@@ -136,15 +240,15 @@ struct is_section : is_specialization_of<cpm::section, std::decay_t<T>> {};
 
 //Direct bench functions
 
-#define CPM_DIRECT_BENCH_SIMPLE(...) CPM_BENCH() { CPM_SIMPLE(__VA_ARGS__); }
-#define CPM_DIRECT_BENCH_TWO_PASS(...) CPM_BENCH() { CPM_TWO_PASS(__VA_ARGS__); }
-#define CPM_DIRECT_BENCH_TWO_PASS_NS(...) CPM_BENCH() { CPM_TWO_PASS_NS(__VA_ARGS__); }
+#define CPM_DIRECT_BENCH_SIMPLE(...) CPM_NAMED_BENCH(CPM_FIRST(__VA_ARGS__)) { CPM_SIMPLE(__VA_ARGS__); }
+#define CPM_DIRECT_BENCH_TWO_PASS(...) CPM_NAMED_BENCH(CPM_FIRST(__VA_ARGS__)) { CPM_TWO_PASS(__VA_ARGS__); }
+#define CPM_DIRECT_BENCH_TWO_PASS_NS(...) CPM_NAMED_BENCH(CPM_FIRST(__VA_ARGS__)) { CPM_TWO_PASS_NS(__VA_ARGS__); }
 
 //Direct bench functions with policies
 
-#define CPM_DIRECT_BENCH_SIMPLE_P(policy,...) CPM_BENCH() { CPM_SIMPLE_P(POLICY(policy),__VA_ARGS__); }
-#define CPM_DIRECT_BENCH_TWO_PASS_P(policy,...) CPM_BENCH() { CPM_TWO_PASS_P(POLICY(policy),__VA_ARGS__); }
-#define CPM_DIRECT_BENCH_TWO_PASS_NS_P(policy,...) CPM_BENCH() { CPM_TWO_PASS_NS_P(POLICY(policy),__VA_ARGS__); }
+#define CPM_DIRECT_BENCH_SIMPLE_P(policy,...) CPM_NAMED_BENCH(CPM_FIRST(__VA_ARGS__)) { CPM_SIMPLE_P(POLICY(policy),__VA_ARGS__); }
+#define CPM_DIRECT_BENCH_TWO_PASS_P(policy,...) CPM_NAMED_BENCH(CPM_FIRST(__VA_ARGS__)) { CPM_TWO_PASS_P(POLICY(policy),__VA_ARGS__); }
+#define CPM_DIRECT_BENCH_TWO_PASS_NS_P(policy,...) CPM_NAMED_BENCH(CPM_FIRST(__VA_ARGS__)) { CPM_TWO_PASS_NS_P(POLICY(policy),__VA_ARGS__); }
 
 //Direct section functions
 
@@ -227,9 +331,15 @@ struct is_section : is_specialization_of<cpm::section, std::decay_t<T>> {};
 #define POLICY(...) __VA_ARGS__
 #define VALUES_POLICY(...) cpm::values_policy<__VA_ARGS__>
 #define NARY_POLICY(...) cpm::simple_nary_policy<__VA_ARGS__>
+#define CARTESIAN_POLICY(...) cpm::cartesian_policy<__VA_ARGS__>
+#define PRUNED_CARTESIAN_POLICY(...) cpm::pruned_cartesian_policy<__VA_ARGS__>
 #define STD_STOP_POLICY cpm::std_stop_policy
 #define STOP_POLICY(start, stop, add, mul) cpm::increasing_policy<start, stop, add, mul, stop_policy::STOP>
 #define TIMEOUT_POLICY(start, stop, add, mul) cpm::increasing_policy<start, stop, add, mul, stop_policy::TIMEOUT>
+#define ADAPTIVE_POLICY(...) cpm::adaptive_policy<__VA_ARGS__>
+#define DISTRIBUTION_POLICY(...) cpm::distribution_policy<__VA_ARGS__>
+#define CACHE_POLICY(B) cpm::cache_policy<cpm::bytes_per_element<B>>
+#define RUNTIME_POLICY(...) cpm::runtime_policy<__VA_ARGS__>
 
 //Helpers for flops function
 #define FLOPS(...) __VA_ARGS__
@@ -237,6 +347,15 @@ struct is_section : is_specialization_of<cpm::section, std::decay_t<T>> {};
 #ifdef CPM_BENCHMARK
 
 int main(int argc, char* argv[]){
+    //A repetition moves the stack and the heap of the benches
+    volatile char* stack_padding = static_cast<volatile char*>(alloca(cpm::layout_value("CPM_LAYOUT_STACK") + 1));
+    stack_padding[0] = 0;
+
+    cpm::pad_heap(cpm::layout_value("CPM_LAYOUT_HEAP"));
+
+    //The parsing consumes the arguments, the repetitions need them
+    std::vector<std::string> arguments(argv, argv + argc);
+
     cxxopts::Options options(argv[0], "filter");
 
     try {
@@ -246,8 +365,24 @@ int main(int argc, char* argv[]){
             ("c,configuration", "Configuration", cxxopts::value<std::string>())
             ("o,output", "Output folder", cxxopts::value<std::string>())
             ("f,oneshot", "Don't save result")
+            ("binary", "Save the results in the binary format (.cpmb)")
+            ("store", "Append the results to the results store of the output folder")
             ("mflops", "Print section summary with MFlops/s")
-            ("filter", "Filter tests/sections to run", cxxopts::value<std::string>())
+            ("resume", "Resume the interrupted run from its journal")
+            ("noise-monitor", "Monitor the noise of the host and flag the samples taken during disturbances")
+            ("exclude-noisy", "Exclude the samples taken during disturbances (implies --noise-monitor)")
+            ("save-samples", "Save the durations of the samples of each point, compared with a Mann-Whitney test by cpm compare (JSON results only)")
+            ("filter", "Filter tests/sections to run, by title or [tags]", cxxopts::value<std::vector<std::string>>())
+            ("regex", "Filter tests/sections to run by regular expression on the title", cxxopts::value<std::vector<std::string>>())
+            ("l,list", "List the tests/sections selected by the filters")
+            ("shard", "Only run the shard i (from 0) of N of the benches", cxxopts::value<std::string>(), "i/N")
+            ("shard-history", "Binary result file (.cpmb) used to balance the shards by duration", cxxopts::value<std::string>())
+            ("shuffle", "Run the benches in a random order, the seed is saved in the results")
+            ("seed", "Seed of the random orders (implies --shuffle)", cxxopts::value<std::size_t>())
+            ("repetitions", "Run the benchmark in N processes with random memory layouts and combine them", cxxopts::value<std::size_t>(), "N")
+            ("randomize-heap", "Also randomize the heap offset of the repetitions")
+            ("sizes", "Sizes of the runtime policies ([title:]1,10,100)", cxxopts::value<std::vector<std::string>>())
+            ("sizes-file", "JSON file with the sizes of the runtime policies", cxxopts::value<std::string>())
             ("h,help", "Print help")
             ;
 
@@ -264,12 +399,118 @@ int main(int argc, char* argv[]){
         return -1;
     }
 
+    std::vector<cpm::bench_filter> filters;
+
+    if(options.count("filter")){
+        for(auto& filter : options["filter"].as<std::vector<std::string>>()){
+            filters.push_back(cpm::make_filter(filter));
+        }
+    }
+
+    if(options.count("regex")){
+        for(auto& pattern : options["regex"].as<std::vector<std::string>>()){
+            try {
+                filters.push_back(cpm::make_regex_filter(pattern));
+            } catch (const std::regex_error& e){
+                std::cout << "cpm: invalid regex \"" << pattern << "\": " << e.what() << std::endl;
+                return -1;
+            }
+        }
+    }
+
+    auto& benchs = cpm::cpm_registry::benchs();
+
+    std::size_t shard = 0;
+    std::size_t shards = 1;
+
+    if(options.count("shard")){
+        auto& value = options["shard"].as<std::string>();
+
+        if(std::sscanf(value.c_str(), "%zu/%zu", &shard, &shards) != 2 || !shards || shard >= shards){
+            std::cout << "cpm: invalid shard \"" << value << "\", expected i/N with 0 <= i < N" << std::endl;
+            return -1;
+        }
+    }
+
+    std::uint32_t seed = 0;
+
+    if(options.count("seed")){
+        auto value = options["seed"].as<std::size_t>();
+
+        if(!value || value > 0xFFFFFFFF){
+            std::cout << "cpm: invalid seed " << value << ", expected 1 to 4294967295" << std::endl;
+            return -1;
+        }
+
+        seed = value;
+    } else if(options.count("shuffle")){
+        std::random_device rd;
+
+        while(!seed){
+            seed = rd();
+        }
+    }
+
+    std::map<std::string, double> durations;
+
+    if(options.count("shard-history")){
+        auto& file = options["shard-history"].as<std::string>();
+
+        if(!cpm::read_bench_durations(file, durations)){
+            std::cout << "cpm: invalid shard history " << file << ", expected a binary result file (see cpm convert)" << std::endl;
+            return -1;
+        }
+    }
+
+    auto assignment = cpm::shard_benchs(benchs, durations, shards);
+
+    auto selected = [&](std::size_t i){
+        return assignment[i] == shard && benchs[i].should_run(filters);
+    };
+
+    if(options.count("list")){
+        for(std::size_t i = 0; i < benchs.size(); ++i){
+            auto& registered = benchs[i];
+
+            if(!selected(i)){
+                continue;
+            }
+
+            if(registered.titles.empty()){
+                std::cout << "<untitled> (" << registered.file << ":" << registered.line << ")" << std::endl;
+            } else {
+                //A function can measure several benches, only the selected ones are listed
+                for(auto& title : registered.titles){
+                    if(cpm::filters_match(filters, title)){
+                        std::cout << title << std::endl;
+                    }
+                }
+            }
+        }
+
+        return 0;
+    }
+
     std::string output_folder{"./results"};
 
     if (options.count("output")){
         output_folder = options["output"].as<std::string>();
     }
 
+    //A repetition saves its results for the parent process
+    bool repetition = cpm::repetition_folder();
+
+    if(repetition){
+        output_folder = cpm::repetition_folder();
+    }
+
+    std::size_t repetitions = options.count("repetitions") ? options["repetitions"].as<std::size_t>() : 1;
+
+    if(repetitions > 1 && options.count("resume")){
+        std::cout << "cpm: --resume cannot be used with --repetitions" << std::endl;
+        return -1;
+    }
+
     std::string benchmark_name{CPM_BENCHMARK};
 
     if (options.count("name")){
@@ -302,22 +543,119 @@ int main(int argc, char* argv[]){
     bench.steps = CPM_STEPS;
 #endif
 
-    if(options.count("filter")){
-        bench.set_filter(options["filter"].as<std::string>());
+    for(auto& filter : filters){
+        bench.add_filter(filter);
+    }
+
+    if(options.count("sizes-file")){
+        auto& file = options["sizes-file"].as<std::string>();
+
+        if(!cpm::load_runtime_sizes(file)){
+            std::cout << "cpm: error reading the sizes from " << file << std::endl;
+            return -1;
+        }
+    }
+
+    if(options.count("sizes")){
+        for(auto& sizes : options["sizes"].as<std::vector<std::string>>()){
+            if(!cpm::add_runtime_sizes(sizes)){
+                std::cout << "cpm: invalid sizes \"" << sizes << "\"" << std::endl;
+                return -1;
+            }
+        }
     }
 
     if(options.count("oneshot")){
         bench.auto_save = false;
     }
 
+    if(options.count("binary") || repetition){
+        bench.binary = true;
+    }
+
+    if(options.count("store") && !repetition){
+        bench.use_store();
+    }
+
     if(options.count("mflops")){
         bench.section_mflops = true;
     }
 
+    if(seed){
+        bench.set_seed(seed);
+    }
+
+    if(options.count("noise-monitor") || options.count("exclude-noisy")){
+        bench.monitor_noise = true;
+        bench.exclude_noisy = options.count("exclude-noisy") > 0;
+    }
+
+    if(options.count("save-samples")){
+        bench.save_samples = true;
+    }
+
+    if(shards > 1){
+        bench.shard = std::to_string(shard) + "/" + std::to_string(shards);
+    }
+
+    if(repetition){
+        bench.auto_save = true;
+    } else if(repetitions > 1){
+        bench.standard_report = false;
+
+        std::uint32_t layout_seed = seed;
+        std::random_device rd;
+
+        while(!layout_seed){
+            layout_seed = rd();
+        }
+
+        auto folder = output_folder + "/.repetitions-" + std::to_string(getpid());
+
+        if(mkdir(folder.c_str(), 0777)){
+            std::cout << "cpm: Failed to create the folder " << folder << std::endl;
+            bench.auto_save = false;
+            return -1;
+        }
+
+        std::vector<cpm::repetition_layout> layouts;
+        auto files = cpm::run_repetitions(arguments, repetitions, options.count("randomize-heap") > 0, folder, layout_seed, layouts);
+
+        bool merged = !files.empty() && bench.merge_repetitions(files, layouts);
+
+        cpm::remove_folder(folder);
+
+        if(!merged){
+            bench.auto_save = false;
+            return -1;
+        }
+
+        if(bench.auto_save){
+            std::cout << "cpm: Merged " << repetitions << " repetitions in " << bench.result_file() << std::endl;
+        }
+
+        return 0;
+    }
+
+    if(options.count("resume")){
+        bench.resume();
+    }
+
     bench.begin();
 
-    for(auto f : cpm::cpm_registry::benchs()){
-        f(bench);
+    //A random order spreads the drift of the host over the benches
+    std::vector<std::size_t> order(benchs.size());
+    std::iota(order.begin(), order.end(), 0);
+
+    if(seed){
+        std::mt19937 generator(seed);
+        std::shuffle(order.begin(), order.end(), generator);
+    }
+
+    for(auto i : order){
+        if(selected(i)){
+            benchs[i].function(bench);
+        }
     }
 
     return 0;
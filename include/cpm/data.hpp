@@ -8,6 +8,16 @@
 #ifndef CPM_DATA_HPP
 #define CPM_DATA_HPP
 
+#include <cstdio>
+#include <cstdint>
+#include <fstream>
+#include <type_traits>
+#include <deque>
+#include <set>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
 #include "cpm/rapidjson.hpp"
 
 namespace cpm {
@@ -16,17 +26,281 @@ using document_t = rapidjson::Document;
 using document_ref = std::reference_wrapper<document_t>;
 using document_cref = std::reference_wrapper<const document_t>;
 
-struct reports_data {
-    std::set<std::string> compilers;
-    std::set<std::string> configurations;
-    std::vector<document_t> documents;
+constexpr const std::uint32_t no_string = 0xFFFFFFFF;
+constexpr const std::uint32_t no_index = 0xFFFFFFFF;
+
+//Strings of the report, each stored once and identified by its id
+struct string_pool {
+    std::uint32_t intern(const std::string& value){
+        auto it = ids.find(value);
+
+        if(it != ids.end()){
+            return it->second;
+        }
+
+        auto id = static_cast<std::uint32_t>(values.size());
+
+        values.push_back(value);
+        ids.emplace(value, id);
+
+        return id;
+    }
+
+    //The id of an existing string, no_string otherwise
+    std::uint32_t find(const std::string& value) const {
+        auto it = ids.find(value);
+        return it == ids.end() ? no_string : it->second;
+    }
+
+    const std::string& operator[](std::uint32_t id) const {
+        return values[id];
+    }
+
+private:
+    std::unordered_map<std::string, std::uint32_t> ids;
+    std::deque<std::string> values;
+};
+
+enum report_metric {
+    METRIC_MEAN,
+    METRIC_MEAN_LB,
+    METRIC_MEAN_UB,
+    METRIC_STDDEV,
+    METRIC_MIN,
+    METRIC_MAX,
+    METRIC_THROUGHPUT_E,
+    METRIC_THROUGHPUT_F,
+    METRICS
+};
+
+//The points of a bench, or of an implementation of a section, in a run
+struct report_series {
+    std::uint32_t title; //Title (or name) without the tags
+    std::uint32_t first; //First point in the columns
+    std::uint32_t count;
+};
 
-    //Temporary data (changed for each generated file)
+struct report_section {
+    std::uint32_t name;  //Name without the tags
+    std::uint32_t first; //First implementation in the series
+    std::uint32_t count;
+};
+
+struct report_run {
+    std::uint32_t name;
+    std::uint32_t tag;
+    std::uint32_t compiler;
+    std::uint32_t configuration;
+    std::uint32_t os;
+    std::uint32_t time;
+
+    std::int64_t timestamp;
+
+    std::uint32_t first_result; //First bench in the series
+    std::uint32_t results;
+    std::uint32_t first_section;
+    std::uint32_t sections;
+};
+
+template<typename T>
+struct report_range {
+    const T* first;
+    const T* last;
+
+    const T* begin() const {
+        return first;
+    }
+
+    const T* end() const {
+        return last;
+    }
+
+    std::size_t size() const {
+        return last - first;
+    }
+
+    const T& operator[](std::size_t i) const {
+        return first[i];
+    }
+};
+
+//The page being generated, the report data is shared by all the pages
+struct report_page {
     std::string file;
     std::string sub_part;
     std::vector<std::pair<std::string, std::string>> files;
 };
 
+/*
+ * Output of a page, accumulated in memory and written at once. The doubles
+ * are formatted like a default std::ostream.
+ */
+struct page_buffer {
+    void clear(){
+        content.clear();
+    }
+
+    page_buffer& operator<<(const std::string& value){
+        content += value;
+        return *this;
+    }
+
+    page_buffer& operator<<(const char* value){
+        content += value;
+        return *this;
+    }
+
+    page_buffer& operator<<(char value){
+        content += value;
+        return *this;
+    }
+
+    page_buffer& operator<<(double value){
+        char digits[32];
+        auto n = snprintf(digits, sizeof(digits), "%g", value);
+        content.append(digits, n);
+        return *this;
+    }
+
+    template<typename T, std::enable_if_t<std::is_integral<T>::value, int> = 42>
+    page_buffer& operator<<(T value){
+        content += std::to_string(value);
+        return *this;
+    }
+
+    bool write(const std::string& path) const {
+        std::ofstream stream(path, std::ios::binary);
+        stream.write(content.data(), content.size());
+        stream.close();
+        return static_cast<bool>(stream);
+    }
+
+private:
+    std::string content;
+};
+
+/*
+ * Columnar model of the runs of the report. The strings are interned and
+ * the points of all the series are stored in one column per attribute.
+ */
+struct reports_data {
+    std::set<std::string> compilers;
+    std::set<std::string> configurations;
+
+    string_pool strings;
+
+    std::vector<report_run> runs;
+    std::vector<report_series> series;
+    std::vector<report_section> sections;
+
+    //The columns of the points
+    std::vector<std::uint32_t> sizes;
+    std::vector<std::uint32_t> regimes; //no_string without regime
+    std::vector<double> metrics[METRICS];
+
+    //Indices of the series, the sections and the points, see build_index()
+    std::unordered_map<std::uint64_t, std::uint32_t> result_index;         //(run, title) -> series
+    std::unordered_map<std::uint64_t, std::uint32_t> section_index;        //(run, name) -> section
+    std::unordered_map<std::uint64_t, std::uint32_t> implementation_index; //(section, name) -> series
+    std::unordered_map<std::uint64_t, std::uint32_t> point_index;          //(series, size) -> point
+
+    const std::string& str(std::uint32_t id) const {
+        return strings[id];
+    }
+
+    report_range<report_series> results(const report_run& run) const {
+        return {series.data() + run.first_result, series.data() + run.first_result + run.results};
+    }
+
+    report_range<report_section> run_sections(const report_run& run) const {
+        return {sections.data() + run.first_section, sections.data() + run.first_section + run.sections};
+    }
+
+    report_range<report_series> implementations(const report_section& section) const {
+        return {series.data() + section.first, series.data() + section.first + section.count};
+    }
+
+    double value(report_metric metric, std::size_t point) const {
+        return metrics[metric][point];
+    }
+
+    std::uint32_t id(const report_run& run) const {
+        return &run - runs.data();
+    }
+
+    std::uint32_t id(const report_series& s) const {
+        return &s - series.data();
+    }
+
+    std::uint32_t id(const report_section& section) const {
+        return &section - sections.data();
+    }
+
+    //Index all the runs, must be called once they are all added
+    void build_index(){
+        result_index.clear();
+        section_index.clear();
+        implementation_index.clear();
+        point_index.clear();
+
+        result_index.reserve(series.size());
+        implementation_index.reserve(series.size());
+        section_index.reserve(sections.size());
+        point_index.reserve(sizes.size());
+
+        //The first occurrence wins, like a scan would
+        for(auto& run : runs){
+            for(auto& result : results(run)){
+                result_index.emplace(key(id(run), result.title), id(result));
+            }
+
+            for(auto& section : run_sections(run)){
+                section_index.emplace(key(id(run), section.name), id(section));
+
+                for(auto& implementation : implementations(section)){
+                    implementation_index.emplace(key(id(section), implementation.title), id(implementation));
+                }
+            }
+        }
+
+        for(auto& s : series){
+            for(std::uint32_t i = s.first; i < s.first + s.count; ++i){
+                point_index.emplace(key(id(s), sizes[i]), i);
+            }
+        }
+    }
+
+    const report_series* find_result(const report_run& run, std::uint32_t title) const {
+        auto i = find(result_index, id(run), title);
+        return i == no_index ? nullptr : &series[i];
+    }
+
+    const report_section* find_section(const report_run& run, std::uint32_t name) const {
+        auto i = find(section_index, id(run), name);
+        return i == no_index ? nullptr : &sections[i];
+    }
+
+    const report_series* find_implementation(const report_section& section, std::uint32_t name) const {
+        auto i = find(implementation_index, id(section), name);
+        return i == no_index ? nullptr : &series[i];
+    }
+
+    //The point of the series with the given size, no_index if there are none
+    std::uint32_t find_point(const report_series& s, std::uint32_t size) const {
+        return find(point_index, id(s), size);
+    }
+
+private:
+    static std::uint64_t key(std::uint32_t parent, std::uint32_t child){
+        return (std::uint64_t(parent) << 32) | child;
+    }
+
+    static std::uint32_t find(const std::unordered_map<std::uint64_t, std::uint32_t>& index, std::uint32_t parent, std::uint32_t child){
+        auto it = index.find(key(parent, child));
+        return it == index.end() ? no_index : it->second;
+    }
+};
+
 } //end of namespace cpm
 
 #endif //CPM_DATA_HPP
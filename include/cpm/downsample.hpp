@@ -0,0 +1,233 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_DOWNSAMPLE_HPP
+#define CPM_DOWNSAMPLE_HPP
+
+#include <cmath>
+#include <vector>
+#include <algorithm>
+
+namespace cpm {
+
+//Point of a time series, x must be increasing
+struct time_point {
+    double x;
+    double y;
+};
+
+enum class downsampling {
+    LTTB,   //Largest triangle three buckets, keeps the visual shape
+    MIN_MAX //Minimum and maximum of each bucket, keeps the extremes
+};
+
+/*
+ * Largest triangle three buckets: keep the first and the last points and,
+ * in each of the threshold - 2 buckets in between, the point forming the
+ * largest triangle with the previous kept point and the average of the next
+ * bucket. Returns the indices of the kept points, in order.
+ */
+inline std::vector<std::size_t> lttb(const std::vector<time_point>& points, std::size_t threshold){
+    std::vector<std::size_t> kept;
+
+    auto n = points.size();
+
+    if(threshold >= n || threshold < 3){
+        for(std::size_t i = 0; i < n; ++i){
+            kept.push_back(i);
+        }
+
+        return kept;
+    }
+
+    double every = double(n - 2) / (threshold - 2);
+
+    std::size_t a = 0;
+    kept.push_back(a);
+
+    for(std::size_t i = 0; i < threshold - 2; ++i){
+        //Average of the next bucket (the last point for the last bucket)
+        auto avg_first = std::size_t((i + 1) * every) + 1;
+        auto avg_last = std::min(std::size_t((i + 2) * every) + 1, n);
+
+        double avg_x = 0.0;
+        double avg_y = 0.0;
+
+        for(auto j = avg_first; j < avg_last; ++j){
+            avg_x += points[j].x;
+            avg_y += points[j].y;
+        }
+
+        avg_x /= (avg_last - avg_first);
+        avg_y /= (avg_last - avg_first);
+
+        //The point of the current bucket with the largest triangle
+        auto first = std::size_t(i * every) + 1;
+        auto last = std::size_t((i + 1) * every) + 1;
+
+        double max_area = -1.0;
+        std::size_t next = first;
+
+        for(auto j = first; j < last; ++j){
+            double area = std::fabs((points[a].x - avg_x) * (points[j].y - points[a].y) - (points[a].x - points[j].x) * (avg_y - points[a].y));
+
+            if(area > max_area){
+                max_area = area;
+                next = j;
+            }
+        }
+
+        kept.push_back(next);
+        a = next;
+    }
+
+    kept.push_back(n - 1);
+
+    return kept;
+}
+
+/*
+ * Min/max bucketing: keep the first and the last points and the minimum and
+ * the maximum of each of the (threshold - 2) / 2 buckets in between. Returns
+ * the indices of the kept points, in order.
+ */
+inline std::vector<std::size_t> min_max_buckets(const std::vector<time_point>& points, std::size_t threshold){
+    std::vector<std::size_t> kept;
+
+    auto n = points.size();
+
+    if(threshold >= n || threshold < 4){
+        for(std::size_t i = 0; i < n; ++i){
+            kept.push_back(i);
+        }
+
+        return kept;
+    }
+
+    auto buckets = (threshold - 2) / 2;
+    double every = double(n - 2) / buckets;
+
+    kept.push_back(0);
+
+    for(std::size_t i = 0; i < buckets; ++i){
+        auto first = std::size_t(i * every) + 1;
+        auto last = std::min(std::size_t((i + 1) * every) + 1, n - 1);
+
+        if(first >= last){
+            continue;
+        }
+
+        auto min = first;
+        auto max = first;
+
+        for(auto j = first; j < last; ++j){
+            if(points[j].y < points[min].y){
+                min = j;
+            }
+
+            if(points[j].y > points[max].y){
+                max = j;
+            }
+        }
+
+        kept.push_back(std::min(min, max));
+
+        if(min != max){
+            kept.push_back(std::max(min, max));
+        }
+    }
+
+    kept.push_back(n - 1);
+
+    return kept;
+}
+
+/*
+ * Indices of the outliers of the series, the points whose modified z-score
+ * (distance to the median in units of median absolute deviation) is larger
+ * than the cutoff.
+ */
+inline std::vector<std::size_t> outliers(const std::vector<time_point>& points, double cutoff = 3.5){
+    std::vector<std::size_t> result;
+
+    if(points.size() < 3){
+        return result;
+    }
+
+    auto median = [](std::vector<double> values){
+        auto middle = values.begin() + values.size() / 2;
+        std::nth_element(values.begin(), middle, values.end());
+        return *middle;
+    };
+
+    std::vector<double> values;
+    for(auto& point : points){
+        values.push_back(point.y);
+    }
+
+    auto m = median(values);
+
+    for(auto& v : values){
+        v = std::fabs(v - m);
+    }
+
+    auto mad = median(values);
+
+    if(mad == 0.0){
+        return result;
+    }
+
+    for(std::size_t i = 0; i < points.size(); ++i){
+        if(0.6745 * std::fabs(points[i].y - m) / mad > cutoff){
+            result.push_back(i);
+        }
+    }
+
+    return result;
+}
+
+/*
+ * Select the points of a time series to display, at most max_points (0 for
+ * all of them) unless there are more outliers. The latest points and the
+ * outliers are always kept, the budget left is downsampled.
+ */
+inline std::vector<bool> downsample(const std::vector<time_point>& points, std::size_t max_points, std::size_t latest = 5, downsampling method = downsampling::LTTB){
+    auto n = points.size();
+
+    if(!max_points || n <= max_points){
+        return std::vector<bool>(n, true);
+    }
+
+    std::vector<bool> kept(n, false);
+    std::size_t forced = 0;
+
+    for(std::size_t i = n - std::min(latest, n); i < n; ++i){
+        kept[i] = true;
+        ++forced;
+    }
+
+    for(auto i : outliers(points)){
+        if(!kept[i]){
+            kept[i] = true;
+            ++forced;
+        }
+    }
+
+    //Below these budgets, the methods keep all the points
+    std::size_t minimum = method == downsampling::LTTB ? 3 : 4;
+    auto budget = max_points > forced + minimum ? max_points - forced : minimum;
+
+    for(auto i : method == downsampling::LTTB ? lttb(points, budget) : min_max_buckets(points, budget)){
+        kept[i] = true;
+    }
+
+    return kept;
+}
+
+} //end of namespace cpm
+
+#endif //CPM_DOWNSAMPLE_HPP
@@ -8,9 +8,13 @@
 #ifndef CPM_DURATION_HPP
 #define CPM_DURATION_HPP
 
+#include <cmath>
 #include <chrono>
 #include <ctime>
+#include <string>
+#include <vector>
 #include <iomanip>
+#include <algorithm>
 
 #include "compat.hpp"
 
@@ -35,6 +39,9 @@ struct measure_result {
     double throughput_e;
     double throughput_f;
     std::size_t flops;
+    double noise = -1.0; //Fraction of the samples taken during disturbances, negative if not monitored
+    std::size_t samples = 0; //Number of samples used for the measure, 0 if unknown
+    std::vector<double> durations = {}; //Durations of the samples (ns), only kept if they are saved
 
     cpp14_constexpr void update(std::size_t size_eff){
         throughput_e = mean == 0.0 ? 0.0 : size_eff / (mean / (1000.0 * 1000.0 * 1000.0));
@@ -42,10 +49,62 @@ struct measure_result {
     }
 };
 
+/*
+ * Combine the measures of several blocks of samples of the same function
+ * into the measure of all the samples. The blocks are weighted by the
+ * number of samples they used (the samples excluded as noisy do not count).
+ */
+inline measure_result merge_results(const std::vector<measure_result>& parts){
+    measure_result result = parts.front();
+
+    double n = 0.0;
+    double sum = 0.0;
+    double sum_squares = 0.0;
+
+    double noise = 0.0;
+    double monitored = 0.0;
+
+    for(std::size_t i = 0; i < parts.size(); ++i){
+        auto& part = parts[i];
+        double count = part.samples ? part.samples : 1;
+
+        n += count;
+        sum += count * part.mean;
+        sum_squares += count * (part.stddev * part.stddev + part.mean * part.mean);
+
+        result.min = std::min(result.min, part.min);
+        result.max = std::max(result.max, part.max);
+
+        if(part.noise >= 0.0){
+            noise += count * part.noise;
+            monitored += count;
+        }
+
+        if(i){
+            result.durations.insert(result.durations.end(), part.durations.begin(), part.durations.end());
+        }
+    }
+
+    result.mean = sum / n;
+    result.stddev = std::sqrt(std::max(0.0, sum_squares / n - result.mean * result.mean));
+
+    double stderror = result.stddev / std::sqrt(n);
+
+    result.mean_lb = result.mean - 1.96 * stderror;
+    result.mean_ub = result.mean + 1.96 * stderror;
+    result.noise = monitored > 0.0 ? noise / monitored : -1.0;
+    result.samples = n;
+
+    return result;
+}
+
 struct measure_full {
     std::size_t size_eff;
     std::string size;
     measure_result result;
+    std::string regime;
+    std::vector<std::string> coordinates;
+    std::vector<measure_result> repetitions = {}; //The measures of each process, when the run was repeated
 };
 
 inline std::string to_string_precision(double duration, int precision = 6){
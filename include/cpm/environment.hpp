@@ -0,0 +1,417 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_ENVIRONMENT_HPP
+#define CPM_ENVIRONMENT_HPP
+
+#include <set>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#include <elf.h>
+#include <unistd.h>
+
+#include "json.hpp"
+#include "compiler.hpp"
+#include "binary.hpp"
+#include "topology.hpp"
+
+namespace cpm {
+
+/*
+ * Environment of a run: the host, its setup at the start of the run and
+ * how the benchmark was built. The values are empty (or zero) when they are
+ * not available.
+ */
+struct environment {
+    std::string cpu_model;
+    std::size_t logical_cpus = 0;
+    std::size_t physical_cores = 0;
+    std::size_t sockets = 0;
+    std::string caches;       //Data caches, "L1d:32K L2:1024K ..."
+    std::string governor;     //Frequency governor of the first CPU
+    std::string frequency;    //Frequency policy of the first CPU, in kHz
+    std::string turbo;        //on or off
+    std::string smt;          //SMT control (on, off, notsupported, ...)
+    std::string cmdline;      //Kernel command line
+    std::string load_average; //1, 5 and 15 minutes load averages
+    std::string thp;          //Transparent hugepages mode
+    std::string build_id;     //ELF build-id of the benchmark
+    std::string isa;          //Instruction sets enabled at compile time
+    std::string march;        //Target architecture at compile time
+    std::string optimized;    //yes if compiled with optimizations
+
+    //Call the visitor on each (key, value) pair, the last one is flagged
+    template<typename Visitor>
+    void visit(Visitor&& visitor) const {
+        visitor("cpu_model", cpu_model, false);
+        visitor("logical_cpus", logical_cpus, false);
+        visitor("physical_cores", physical_cores, false);
+        visitor("sockets", sockets, false);
+        visitor("caches", caches, false);
+        visitor("governor", governor, false);
+        visitor("frequency", frequency, false);
+        visitor("turbo", turbo, false);
+        visitor("smt", smt, false);
+        visitor("cmdline", cmdline, false);
+        visitor("load_average", load_average, false);
+        visitor("thp", thp, false);
+        visitor("build_id", build_id, false);
+        visitor("isa", isa, false);
+        visitor("march", march, false);
+        visitor("optimized", optimized, true);
+    }
+
+    //Write the fields in the current object of the writer
+    void write(json_writer& writer) const {
+        visit([&writer](const char* key, const auto& value, bool last){
+            writer.value(key, value, !last);
+        });
+    }
+
+    //Compact JSON object of the environment
+    std::string json() const {
+        std::string result = "{";
+
+        visit([&result](const char* key, const auto& value, bool last){
+            result += "\"";
+            result += key;
+            result += "\": ";
+            result += json_value(value);
+            result += last ? "}" : ", ";
+        });
+
+        return result;
+    }
+
+    //The problems of the setup that make the measures noisy
+    std::vector<std::string> warnings() const {
+        std::vector<std::string> result;
+
+        if(!governor.empty() && governor != "performance"){
+            result.push_back("The CPU frequency governor is " + governor + ", use the performance governor for stable results");
+        }
+
+        if(turbo == "on"){
+            result.push_back("Turbo boost is enabled, the frequency depends on the temperature and the load");
+        }
+
+        if(!load_average.empty() && std::strtod(load_average.c_str(), nullptr) >= 1.0){
+            result.push_back("The load average is " + load_average + ", other processes are competing with the benchmark");
+        }
+
+        if(optimized != "yes"){
+            result.push_back("The benchmark is compiled without optimizations");
+        }
+
+        return result;
+    }
+
+private:
+    static std::string json_value(const std::string& value){
+        return "\"" + json_escape(value) + "\"";
+    }
+
+    static std::string json_value(std::size_t value){
+        return std::to_string(value);
+    }
+};
+
+namespace detail {
+
+//The complete first line of a file, empty if it is not readable
+inline std::string read_line(const std::string& path){
+    std::ifstream stream(path);
+    std::string line;
+    std::getline(stream, line);
+    return line;
+}
+
+//The value of the first "key : value" line of /proc/cpuinfo with the given key
+inline std::string cpuinfo_value(const std::string& cpuinfo, const std::string& key){
+    std::istringstream stream(cpuinfo);
+    std::string line;
+
+    while(std::getline(stream, line)){
+        if(line.compare(0, key.size(), key) == 0){
+            auto colon = line.find(':');
+
+            if(colon != std::string::npos && line.find_first_not_of(" \t", key.size()) == colon){
+                return line.substr(std::min(line.size(), colon + 2));
+            }
+        }
+    }
+
+    return "";
+}
+
+inline void read_topology(environment& env){
+    std::ifstream stream("/proc/cpuinfo");
+    std::string cpuinfo((std::istreambuf_iterator<char>(stream)), std::istreambuf_iterator<char>());
+
+    env.cpu_model = cpuinfo_value(cpuinfo, "model name");
+
+    if(env.cpu_model.empty()){
+        env.cpu_model = cpuinfo_value(cpuinfo, "Model");
+    }
+
+    std::set<std::string> packages;
+    std::set<std::pair<std::string, std::string>> cores;
+
+    std::istringstream lines(cpuinfo);
+    std::string line;
+    std::string package;
+
+    while(std::getline(lines, line)){
+        auto colon = line.find(':');
+
+        if(colon == std::string::npos){
+            continue;
+        }
+
+        auto key = line.substr(0, line.find_last_not_of(" \t", colon - 1) + 1);
+        auto value = line.substr(std::min(line.size(), colon + 2));
+
+        if(key == "processor"){
+            ++env.logical_cpus;
+        } else if(key == "physical id"){
+            package = value;
+            packages.insert(value);
+        } else if(key == "core id"){
+            cores.emplace(package, value);
+        }
+    }
+
+    if(!env.logical_cpus){
+        env.logical_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    }
+
+    env.sockets = packages.empty() ? 1 : packages.size();
+    env.physical_cores = cores.empty() ? env.logical_cpus : cores.size();
+}
+
+inline void read_frequency(environment& env){
+    const std::string cpufreq = "/sys/devices/system/cpu/cpu0/cpufreq/";
+
+    env.governor = read_line(cpufreq + "scaling_governor");
+
+    auto min = read_line(cpufreq + "scaling_min_freq");
+    auto max = read_line(cpufreq + "scaling_max_freq");
+    auto current = read_line(cpufreq + "scaling_cur_freq");
+
+    if(!min.empty() && !max.empty()){
+        env.frequency = min + "-" + max + (current.empty() ? "" : " (current " + current + ")");
+    }
+
+    auto no_turbo = read_line("/sys/devices/system/cpu/intel_pstate/no_turbo");
+    auto boost = read_line("/sys/devices/system/cpu/cpufreq/boost");
+
+    if(!no_turbo.empty()){
+        env.turbo = no_turbo == "0" ? "on" : "off";
+    } else if(!boost.empty()){
+        env.turbo = boost == "1" ? "on" : "off";
+    }
+
+    env.smt = read_line("/sys/devices/system/cpu/smt/control");
+}
+
+//The selected value of a sysfs setting listing the choices ("always [madvise] never")
+inline std::string selected_value(const std::string& line){
+    auto begin = line.find('[');
+    auto end = line.find(']', begin);
+
+    if(begin == std::string::npos || end == std::string::npos){
+        return line;
+    }
+
+    return line.substr(begin + 1, end - begin - 1);
+}
+
+//The GNU build-id note of the ELF file, in hexadecimal
+inline std::string elf_build_id(const std::string& path){
+    file_mapping mapping;
+
+    if(!mapping.open(path) || mapping.size < sizeof(Elf64_Ehdr)){
+        return "";
+    }
+
+    auto& header = *reinterpret_cast<const Elf64_Ehdr*>(mapping.data);
+
+    if(std::memcmp(header.e_ident, ELFMAG, SELFMAG) != 0 || header.e_ident[EI_CLASS] != ELFCLASS64
+            || header.e_phoff + std::uint64_t(header.e_phnum) * sizeof(Elf64_Phdr) > mapping.size){
+        return "";
+    }
+
+    auto segments = reinterpret_cast<const Elf64_Phdr*>(mapping.data + header.e_phoff);
+
+    for(std::size_t i = 0; i < header.e_phnum; ++i){
+        if(segments[i].p_type != PT_NOTE || segments[i].p_offset + segments[i].p_filesz > mapping.size){
+            continue;
+        }
+
+        auto note = mapping.data + segments[i].p_offset;
+        auto end = note + segments[i].p_filesz;
+
+        //The name and the descriptor of each note are aligned on 4 bytes
+        while(note + sizeof(Elf64_Nhdr) <= end){
+            auto& n = *reinterpret_cast<const Elf64_Nhdr*>(note);
+            auto name = note + sizeof(Elf64_Nhdr);
+            auto desc = name + ((n.n_namesz + 3) & ~3U);
+
+            if(desc + n.n_descsz > end){
+                break;
+            }
+
+            if(n.n_type == NT_GNU_BUILD_ID && n.n_namesz == 4 && std::memcmp(name, "GNU", 4) == 0){
+                static const char digits[] = "0123456789abcdef";
+
+                std::string id;
+                for(std::size_t j = 0; j < n.n_descsz; ++j){
+                    id += digits[(static_cast<unsigned char>(desc[j]) >> 4) & 0xF];
+                    id += digits[static_cast<unsigned char>(desc[j]) & 0xF];
+                }
+
+                return id;
+            }
+
+            note = desc + ((n.n_descsz + 3) & ~3U);
+        }
+    }
+
+    return "";
+}
+
+//The instruction sets enabled when the benchmark was compiled
+inline std::string compiled_isa(){
+    std::string isa;
+
+    auto add = [&isa](const char* name){
+        isa += isa.empty() ? "" : " ";
+        isa += name;
+    };
+
+#ifdef __SSE2__
+    add("SSE2");
+#endif
+#ifdef __SSE3__
+    add("SSE3");
+#endif
+#ifdef __SSSE3__
+    add("SSSE3");
+#endif
+#ifdef __SSE4_1__
+    add("SSE4.1");
+#endif
+#ifdef __SSE4_2__
+    add("SSE4.2");
+#endif
+#ifdef __AVX__
+    add("AVX");
+#endif
+#ifdef __AVX2__
+    add("AVX2");
+#endif
+#ifdef __FMA__
+    add("FMA");
+#endif
+#ifdef __AVX512F__
+    add("AVX512F");
+#endif
+#ifdef __AVX512BW__
+    add("AVX512BW");
+#endif
+#ifdef __AVX512VL__
+    add("AVX512VL");
+#endif
+#ifdef __ARM_NEON
+    add("NEON");
+#endif
+#ifdef __ARM_FEATURE_SVE
+    add("SVE");
+#endif
+
+    (void) add;
+
+    return isa;
+}
+
+//The target architecture when the benchmark was compiled, CPM_MARCH overrides it
+inline std::string compiled_march(){
+#if defined(CPM_MARCH)
+    return TO_STRING(CPM_MARCH);
+#elif defined(__znver4__)
+    return "znver4";
+#elif defined(__znver3__)
+    return "znver3";
+#elif defined(__znver2__)
+    return "znver2";
+#elif defined(__znver1__)
+    return "znver1";
+#elif defined(__sapphirerapids__)
+    return "sapphirerapids";
+#elif defined(__icelake_server__)
+    return "icelake-server";
+#elif defined(__icelake_client__)
+    return "icelake-client";
+#elif defined(__skylake_avx512__)
+    return "skylake-avx512";
+#elif defined(__skylake__)
+    return "skylake";
+#elif defined(__broadwell__)
+    return "broadwell";
+#elif defined(__haswell__)
+    return "haswell";
+#elif defined(__x86_64__)
+    return "x86-64";
+#elif defined(__aarch64__)
+    return "aarch64";
+#else
+    return "";
+#endif
+}
+
+} //end of namespace detail
+
+//Capture the environment of the current process
+inline environment capture_environment(){
+    environment env;
+
+    detail::read_topology(env);
+    detail::read_frequency(env);
+
+    for(auto& cache : data_caches()){
+        env.caches += (env.caches.empty() ? "" : " ") + cache.name + ":" + std::to_string(cache.size / 1024) + "K";
+    }
+
+    env.cmdline = detail::read_line("/proc/cmdline");
+
+    std::istringstream loadavg(detail::read_line("/proc/loadavg"));
+    std::string load;
+    for(std::size_t i = 0; i < 3 && loadavg >> load; ++i){
+        env.load_average += (i ? " " : "") + load;
+    }
+
+    env.thp = detail::selected_value(detail::read_line("/sys/kernel/mm/transparent_hugepage/enabled"));
+    env.build_id = detail::elf_build_id("/proc/self/exe");
+    env.isa = detail::compiled_isa();
+    env.march = detail::compiled_march();
+
+#ifdef __OPTIMIZE__
+    env.optimized = "yes";
+#else
+    env.optimized = "no";
+#endif
+
+    return env;
+}
+
+} //end of namespace cpm
+
+#endif //CPM_ENVIRONMENT_HPP
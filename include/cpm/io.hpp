@@ -67,17 +67,35 @@ inline std::string make_absolute(const std::string& folder){
     return abs;
 }
 
+//Find a free result number with a logarithmic number of probes, the
+//results being numbered from 1 without holes
 inline std::string get_free_file(const std::string& base_folder){
-    std::size_t result_name = 0;
-    std::string result_folder;
+    auto used = [&base_folder](std::size_t number){
+        struct stat buffer;
+        auto file = base_folder + std::to_string(number) + ".cpm";
+        return stat(file.c_str(), &buffer) == 0 || stat((file + "b").c_str(), &buffer) == 0;
+    };
+
+    //low is used (or 0) and high is free
+    std::size_t low = 0;
+    std::size_t high = 1;
+
+    while(used(high)){
+        low = high;
+        high *= 2;
+    }
 
-    struct stat buffer;
-    do {
-        ++result_name;
-        result_folder = base_folder + std::to_string(result_name) + ".cpm";
-    } while(stat(result_folder.c_str(), &buffer) == 0);
+    while(high - low > 1){
+        auto middle = low + (high - low) / 2;
+
+        if(used(middle)){
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
 
-    return std::to_string(result_name);
+    return std::to_string(high);
 }
 
 inline bool folder_exists(const std::string& folder){
@@ -0,0 +1,263 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_JOURNAL_HPP
+#define CPM_JOURNAL_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <csignal>
+#include <cerrno>
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace cpm {
+
+//Number of journal entries between two synchronizations to disk
+#ifndef CPM_JOURNAL_SYNC
+#define CPM_JOURNAL_SYNC 16
+#endif
+
+namespace detail {
+
+inline volatile std::sig_atomic_t& journal_fd(){
+    static volatile std::sig_atomic_t fd = -1;
+    return fd;
+}
+
+//The entries are written as soon as they are complete, only the
+//synchronization to disk is left on SIGINT/SIGTERM
+inline void journal_signal_handler(int signal){
+    if(journal_fd() >= 0){
+        fsync(journal_fd());
+    }
+
+    std::signal(signal, SIG_DFL);
+    std::raise(signal);
+}
+
+//Parse a flat JSON object of strings and numbers on a single line
+inline bool parse_journal_line(const std::string& line, std::map<std::string, std::string>& values){
+    std::size_t i = 0;
+
+    auto skip = [&](){
+        while(i < line.size() && line[i] == ' '){
+            ++i;
+        }
+    };
+
+    auto read_string = [&](std::string& value){
+        if(i >= line.size() || line[i] != '"'){
+            return false;
+        }
+
+        for(++i; i < line.size() && line[i] != '"'; ++i){
+            if(line[i] == '\\'){
+                if(++i == line.size()){
+                    return false;
+                }
+
+                switch(line[i]){
+                    case 'n': value += '\n'; break;
+                    case 't': value += '\t'; break;
+                    case 'r': value += '\r'; break;
+                    case 'u': {
+                        //A damaged line must only be rejected
+                        if(i + 4 >= line.size() || !std::all_of(line.begin() + i + 1, line.begin() + i + 5, [](char c){ return std::isxdigit(static_cast<unsigned char>(c)); })){
+                            return false;
+                        }
+
+                        value += static_cast<char>(std::strtol(line.substr(i + 1, 4).c_str(), nullptr, 16));
+                        i += 4;
+                        break;
+                    }
+                    default: value += line[i];
+                }
+            } else {
+                value += line[i];
+            }
+        }
+
+        return i++ < line.size();
+    };
+
+    skip();
+
+    if(i >= line.size() || line[i++] != '{'){
+        return false;
+    }
+
+    while(true){
+        skip();
+
+        std::string key;
+        if(!read_string(key)){
+            return false;
+        }
+
+        skip();
+
+        if(i >= line.size() || line[i++] != ':'){
+            return false;
+        }
+
+        skip();
+
+        std::string value;
+        if(i < line.size() && line[i] == '"'){
+            if(!read_string(value)){
+                return false;
+            }
+        } else {
+            while(i < line.size() && line[i] != ',' && line[i] != '}' && line[i] != ' '){
+                value += line[i++];
+            }
+        }
+
+        values[key] = value;
+
+        skip();
+
+        if(i < line.size() && line[i] == ','){
+            ++i;
+        } else {
+            break;
+        }
+    }
+
+    return i < line.size() && line[i] == '}';
+}
+
+} //end of namespace detail
+
+/*
+ * Append-only journal of JSON lines. Each entry is written as soon as it is
+ * appended, the file is synchronized to disk every CPM_JOURNAL_SYNC entries
+ * and when SIGINT or SIGTERM is received.
+ */
+struct journal {
+    journal() = default;
+
+    journal(const journal&) = delete;
+    journal& operator=(const journal&) = delete;
+
+    ~journal(){
+        close();
+    }
+
+    bool is_open() const {
+        return fd >= 0;
+    }
+
+    //Open the journal, keeping the given entries
+    bool open(const std::string& path, const std::vector<std::string>& entries = {}){
+        close();
+
+        fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_APPEND | O_CLOEXEC, 0644);
+
+        if(fd < 0){
+            return false;
+        }
+
+        for(auto& entry : entries){
+            write_line(entry);
+        }
+
+        sync();
+
+        detail::journal_fd() = fd;
+
+        std::signal(SIGINT, detail::journal_signal_handler);
+        std::signal(SIGTERM, detail::journal_signal_handler);
+
+        return true;
+    }
+
+    void append(const std::string& entry){
+        if(fd < 0){
+            return;
+        }
+
+        write_line(entry);
+
+        if(++pending >= CPM_JOURNAL_SYNC){
+            sync();
+        }
+    }
+
+    void sync(){
+        if(fd >= 0){
+            fsync(fd);
+            pending = 0;
+        }
+    }
+
+    void close(){
+        if(fd >= 0){
+            sync();
+
+            detail::journal_fd() = -1;
+
+            std::signal(SIGINT, SIG_DFL);
+            std::signal(SIGTERM, SIG_DFL);
+
+            ::close(fd);
+            fd = -1;
+        }
+    }
+
+    //Read the complete entries of an existing journal
+    static std::vector<std::string> read(const std::string& path){
+        std::vector<std::string> entries;
+
+        std::ifstream stream(path);
+
+        std::string line;
+        std::map<std::string, std::string> values;
+        while(std::getline(stream, line)){
+            //An interrupted entry is incomplete and does not parse
+            if(detail::parse_journal_line(line, values)){
+                entries.push_back(line);
+            }
+        }
+
+        return entries;
+    }
+
+private:
+    void write_line(std::string line){
+        line += '\n';
+
+        std::size_t written = 0;
+        while(written < line.size()){
+            auto n = ::write(fd, line.data() + written, line.size() - written);
+
+            if(n < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+
+                return;
+            }
+
+            written += n;
+        }
+    }
+
+    int fd = -1;
+    std::size_t pending = 0;
+};
+
+} //end of namespace cpm
+
+#endif //CPM_JOURNAL_HPP
@@ -11,84 +11,284 @@
 #include <unistd.h>
 #include <sys/stat.h>
 
+#include <string>
+#include <vector>
+#include <ostream>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include <algorithm>
+
 namespace cpm {
 
-template<typename T>
-inline void write_value(std::ofstream& stream, std::size_t& indent, const std::string& tag, const T& value, bool comma = true){
-    if(comma){
-        stream << std::string(indent, ' ') << "\"" << tag << "\": \"" << value << "\",\n";
-    } else {
-        stream << std::string(indent, ' ') << "\"" << tag << "\": \"" << value << "\"\n";
+namespace detail {
+
+//Escape the characters of a JSON string, output(data, n) receives the escaped pieces
+template<typename Output>
+void json_escape(const char* value, std::size_t n, Output&& output){
+    std::size_t plain = 0;
+
+    for(std::size_t i = 0; i < n; ++i){
+        auto c = value[i];
+
+        if(c != '"' && c != '\\' && static_cast<unsigned char>(c) >= 0x20){
+            continue;
+        }
+
+        output(value + plain, i - plain);
+        plain = i + 1;
+
+        if(c == '"' || c == '\\'){
+            char escaped[2] = {'\\', c};
+            output(escaped, 2);
+        } else if(c == '\n'){
+            output("\\n", 2);
+        } else if(c == '\t'){
+            output("\\t", 2);
+        } else {
+            char escaped[8];
+            auto m = snprintf(escaped, sizeof(escaped), "\\u%04x", c);
+            output(escaped, m);
+        }
     }
+
+    output(value + plain, n - plain);
 }
 
-template<>
-inline void write_value(std::ofstream& stream, std::size_t& indent, const std::string& tag, const std::size_t& value, bool comma){
-    if(comma){
-        stream << std::string(indent, ' ') << "\"" << tag << "\": " << value << ",\n";
-    } else {
-        stream << std::string(indent, ' ') << "\"" << tag << "\": " << value << "\n";
-    }
+} //end of namespace detail
+
+inline std::string json_escape(const std::string& value){
+    std::string escaped;
+
+    detail::json_escape(value.data(), value.size(), [&escaped](const char* data, std::size_t n){
+        escaped.append(data, n);
+    });
+
+    return escaped;
 }
 
-template<>
-inline void write_value(std::ofstream& stream, std::size_t& indent, const std::string& tag, const int64_t& value, bool comma){
-    if(comma){
-        stream << std::string(indent, ' ') << "\"" << tag << "\": " << value << ",\n";
-    } else {
-        stream << std::string(indent, ' ') << "\"" << tag << "\": " << value << "\n";
+/*
+ * Streaming writer of indented JSON documents. The output is accumulated in
+ * a fixed buffer and written to the stream by blocks, nothing is allocated
+ * while writing. The strings are escaped and the doubles are written with
+ * the shortest precision (up to 17 digits) that reads back to the same value.
+ */
+struct json_writer {
+    explicit json_writer(std::ostream& stream) : stream(stream) {}
+
+    json_writer(const json_writer&) = delete;
+    json_writer& operator=(const json_writer&) = delete;
+
+    ~json_writer(){
+        flush();
     }
-}
 
-template<>
-inline void write_value(std::ofstream& stream, std::size_t& indent, const std::string& tag, const long long& value, bool comma){
-    if(comma){
-        stream << std::string(indent, ' ') << "\"" << tag << "\": " << value << ",\n";
-    } else {
-        stream << std::string(indent, ' ') << "\"" << tag << "\": " << value << "\n";
+    void value(const char* tag, const std::string& value, bool comma = true){
+        key(tag);
+        write_string(value.data(), value.size());
+        end_line(comma);
     }
-}
 
-template<>
-inline void write_value(std::ofstream& stream, std::size_t& indent, const std::string& tag, const double& value, bool comma){
-    stream << std::fixed;
-    if(comma){
-        stream << std::string(indent, ' ') << "\"" << tag << "\": " << value << ",\n";
-    } else {
-        stream << std::string(indent, ' ') << "\"" << tag << "\": " << value << "\n";
+    void value(const char* tag, const char* value, bool comma = true){
+        key(tag);
+        write_string(value, std::strlen(value));
+        end_line(comma);
     }
-    stream << std::scientific;
-}
 
-inline void start_array(std::ofstream& stream, std::size_t& indent, const std::string& tag){
-    stream << std::string(indent, ' ') << "\"" << tag << "\": " << "[" << "\n";
-    indent += 2;
-}
+    void value(const char* tag, double value, bool comma = true){
+        key(tag);
+        write_number(value);
+        end_line(comma);
+    }
 
-inline void close_array(std::ofstream& stream, std::size_t& indent, bool comma){
-    indent -= 2;
+    template<typename T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value, int> = 42>
+    void value(const char* tag, T value, bool comma = true){
+        key(tag);
+        write_integer(value);
+        end_line(comma);
+    }
+
+    //Array of values already formatted as JSON, on a single line
+    void raw_array(const char* tag, const std::vector<std::string>& values, bool comma = true){
+        key(tag);
+
+        put('[');
+        for(std::size_t i = 0; i < values.size(); ++i){
+            if(i){
+                write(", ", 2);
+            }
 
-    if(comma){
-        stream << std::string(indent, ' ') << "]," << "\n";
-    } else {
-        stream << std::string(indent, ' ') << "]" << "\n";
+            write(values[i].data(), values[i].size());
+        }
+        put(']');
+
+        end_line(comma);
     }
-}
 
-inline void start_sub(std::ofstream& stream, std::size_t& indent){
-    stream << std::string(indent, ' ') << "{" << "\n";
-    indent += 2;
-}
+    //Array of numbers, on a single line
+    void array(const char* tag, const std::vector<double>& values, bool comma = true){
+        key(tag);
+
+        put('[');
+        for(std::size_t i = 0; i < values.size(); ++i){
+            if(i){
+                write(", ", 2);
+            }
 
-inline void close_sub(std::ofstream& stream, std::size_t& indent, bool comma){
-    indent -= 2;
+            write_number(values[i]);
+        }
+        put(']');
 
-    if(comma){
-        stream << std::string(indent, ' ') << "}," << "\n";
-    } else {
-        stream << std::string(indent, ' ') << "}" << "\n";
+        end_line(comma);
     }
-}
+
+    void start_array(const char* tag){
+        key(tag);
+        write("[\n", 2);
+        indent += 2;
+    }
+
+    void close_array(bool comma){
+        indent -= 2;
+        spaces();
+        put(']');
+        end_line(comma);
+    }
+
+    //Start an object member, closed with close_sub()
+    void start_object(const char* tag){
+        key(tag);
+        write("{\n", 2);
+        indent += 2;
+    }
+
+    void start_sub(){
+        spaces();
+        write("{\n", 2);
+        indent += 2;
+    }
+
+    void close_sub(bool comma){
+        indent -= 2;
+        spaces();
+        put('}');
+        end_line(comma);
+    }
+
+    void flush(){
+        if(used){
+            stream.write(buffer, used);
+            used = 0;
+        }
+    }
+
+private:
+    void put(char c){
+        if(used == sizeof(buffer)){
+            flush();
+        }
+
+        buffer[used++] = c;
+    }
+
+    void write(const char* data, std::size_t n){
+        if(used + n > sizeof(buffer)){
+            flush();
+
+            if(n > sizeof(buffer)){
+                stream.write(data, n);
+                return;
+            }
+        }
+
+        std::memcpy(buffer + used, data, n);
+        used += n;
+    }
+
+    void spaces(){
+        static const char blank[] = "                                                                ";
+
+        std::size_t n = indent;
+        while(n){
+            auto m = std::min(n, sizeof(blank) - 1);
+            write(blank, m);
+            n -= m;
+        }
+    }
+
+    void key(const char* tag){
+        spaces();
+        write_string(tag, std::strlen(tag));
+        write(": ", 2);
+    }
+
+    void end_line(bool comma){
+        if(comma){
+            write(",\n", 2);
+        } else {
+            put('\n');
+        }
+    }
+
+    void write_string(const char* value, std::size_t n){
+        put('"');
+
+        detail::json_escape(value, n, [this](const char* data, std::size_t m){
+            write(data, m);
+        });
+
+        put('"');
+    }
+
+    void write_number(double value){
+        //JSON has no representation for infinities and NaN
+        if(!std::isfinite(value)){
+            write("null", 4);
+            return;
+        }
+
+        char digits[32];
+        int n = 0;
+
+        for(int precision = 15; precision <= 17; ++precision){
+            n = snprintf(digits, sizeof(digits), "%.*g", precision, value);
+
+            if(std::strtod(digits, nullptr) == value){
+                break;
+            }
+        }
+
+        write(digits, n);
+    }
+
+    template<typename T>
+    void write_integer(T value){
+        char digits[24];
+        std::size_t n = sizeof(digits);
+
+        bool negative = value < 0;
+        auto v = negative ? 0 - static_cast<std::make_unsigned_t<T>>(value) : static_cast<std::make_unsigned_t<T>>(value);
+
+        do {
+            digits[--n] = '0' + v % 10;
+            v /= 10;
+        } while(v);
+
+        if(negative){
+            digits[--n] = '-';
+        }
+
+        write(digits + n, sizeof(digits) - n);
+    }
+
+    std::ostream& stream;
+    std::size_t indent = 0;
+
+    char buffer[64 * 1024];
+    std::size_t used = 0;
+};
 
 } //end of namespace cpm
 
@@ -0,0 +1,615 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_NOISE_HPP
+#define CPM_NOISE_HPP
+
+#include <map>
+#include <atomic>
+#include <thread>
+#include <string>
+#include <vector>
+#include <cctype>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+
+#include <sched.h>
+#include <dirent.h>
+#include <pthread.h>
+
+#include "duration.hpp"
+#include "environment.hpp"
+
+namespace cpm {
+
+//The causes of a disturbance, as flags
+enum noise_cause : std::uint32_t {
+    NOISE_ACTIVITY   = 1 << 0, //The other CPUs are busy or the CPU time is stolen
+    NOISE_FREQUENCY  = 1 << 1, //The frequency of the measurement core dropped
+    NOISE_THERMAL    = 1 << 2, //The CPU is throttled by the temperature
+    NOISE_INTERRUPTS = 1 << 3, //Interrupts were handled on the measurement core
+    NOISE_HICCUP     = 1 << 4, //The system did not wake a thread on time
+    NOISE_MIGRATION  = 1 << 5  //The measurement moved to another core
+};
+
+//Period of time during which the measures are not trusted
+struct disturbance {
+    timer_clock::time_point begin;
+    timer_clock::time_point end;
+    std::uint32_t causes;
+};
+
+inline std::string noise_causes_str(std::uint32_t causes){
+    static const char* names[] = {"activity", "frequency", "thermal", "interrupts", "hiccup", "migration"};
+
+    std::string result;
+
+    for(std::size_t i = 0; i < sizeof(names) / sizeof(names[0]); ++i){
+        if(causes & (1U << i)){
+            result += (result.empty() ? "" : ",") + std::string(names[i]);
+        }
+    }
+
+    return result;
+}
+
+namespace detail {
+
+//Busy and total time of a CPU, in ticks
+struct cpu_time {
+    std::uint64_t busy = 0;
+    std::uint64_t total = 0;
+    std::uint64_t stolen = 0; //irq, softirq and steal
+};
+
+//The times of each CPU from /proc/stat, indexed by CPU
+inline std::vector<cpu_time> read_cpu_times(){
+    std::vector<cpu_time> times;
+
+    std::ifstream stream("/proc/stat");
+    std::string line;
+
+    while(std::getline(stream, line)){
+        if(line.compare(0, 3, "cpu") != 0 || line.size() < 4 || !std::isdigit(line[3])){
+            continue;
+        }
+
+        std::istringstream fields(line.substr(3));
+
+        std::size_t cpu;
+        std::uint64_t user = 0, nice = 0, system = 0, idle = 0, iowait = 0, irq = 0, softirq = 0, steal = 0;
+        fields >> cpu >> user >> nice >> system >> idle >> iowait >> irq >> softirq >> steal;
+
+        if(cpu >= times.size()){
+            times.resize(cpu + 1);
+        }
+
+        times[cpu].busy = user + nice + system + irq + softirq + steal;
+        times[cpu].total = times[cpu].busy + idle + iowait;
+        times[cpu].stolen = irq + softirq + steal;
+    }
+
+    return times;
+}
+
+//CPU time of a thread of the process, in ticks, and the CPU it last ran on
+struct thread_time {
+    std::uint64_t ticks = 0;
+    int cpu = -1;
+};
+
+//The times of the threads of the current process, by thread id
+inline std::map<std::string, thread_time> read_thread_times(){
+    std::map<std::string, thread_time> times;
+
+    DIR* dir = opendir("/proc/self/task");
+
+    if(!dir){
+        return times;
+    }
+
+    while(auto entry = readdir(dir)){
+        std::string tid = entry->d_name;
+
+        if(tid == "." || tid == ".."){
+            continue;
+        }
+
+        std::ifstream stream("/proc/self/task/" + tid + "/stat");
+        std::string line;
+        std::getline(stream, line);
+
+        //The name of the thread may contain spaces, the fields start after it (with the state, field 3)
+        auto name_end = line.rfind(')');
+
+        if(name_end == std::string::npos){
+            continue;
+        }
+
+        std::istringstream fields(line.substr(name_end + 1));
+        std::vector<std::string> values;
+        std::string value;
+
+        while(fields >> value){
+            values.push_back(value);
+        }
+
+        if(values.size() > 36){
+            auto& time = times[tid];
+            time.ticks = std::strtoull(values[11].c_str(), nullptr, 10) + std::strtoull(values[12].c_str(), nullptr, 10); //utime + stime
+            time.cpu = std::atoi(values[36].c_str());
+        }
+    }
+
+    closedir(dir);
+
+    return times;
+}
+
+//The interrupts handled by the CPU, except the local timer ticks
+inline std::uint64_t read_interrupts(std::size_t cpu){
+    std::ifstream stream("/proc/interrupts");
+    std::string line;
+
+    if(!std::getline(stream, line)){
+        return 0;
+    }
+
+    //The header names the columns of the online CPUs
+    std::istringstream header(line);
+    std::string name;
+    std::size_t column = 0;
+    bool found = false;
+
+    while(header >> name){
+        if(name == "CPU" + std::to_string(cpu)){
+            found = true;
+            break;
+        }
+
+        ++column;
+    }
+
+    if(!found){
+        return 0;
+    }
+
+    std::uint64_t count = 0;
+
+    while(std::getline(stream, line)){
+        std::istringstream fields(line);
+        std::string label;
+        fields >> label;
+
+        if(label == "LOC:"){
+            continue;
+        }
+
+        std::uint64_t value = 0;
+        std::size_t i = 0;
+
+        for(; i <= column && fields >> value; ++i){}
+
+        if(i == column + 1){
+            count += value;
+        }
+    }
+
+    return count;
+}
+
+//The current frequency of the CPU, in kHz, 0 if not available
+inline std::uint64_t read_cpu_frequency(std::size_t cpu){
+    return std::strtoull(read_line("/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/cpufreq/scaling_cur_freq").c_str(), nullptr, 10);
+}
+
+//The number of thermal throttling events of the CPU (core and package)
+inline std::uint64_t read_throttle_count(std::size_t cpu){
+    auto base = "/sys/devices/system/cpu/cpu" + std::to_string(cpu) + "/thermal_throttle/";
+
+    return std::strtoull(read_line(base + "core_throttle_count").c_str(), nullptr, 10)
+         + std::strtoull(read_line(base + "package_throttle_count").c_str(), nullptr, 10);
+}
+
+//Temperature file of a thermal zone and the temperature at which it throttles
+struct thermal_zone {
+    std::string temperature;
+    long passive;
+};
+
+//The thermal zones with a passive (throttling) trip point
+inline std::vector<thermal_zone> read_thermal_zones(){
+    std::vector<thermal_zone> zones;
+
+    const std::string base = "/sys/class/thermal/";
+
+    DIR* dir = opendir(base.c_str());
+
+    if(!dir){
+        return zones;
+    }
+
+    while(auto entry = readdir(dir)){
+        std::string name = entry->d_name;
+
+        if(name.compare(0, 12, "thermal_zone") != 0){
+            continue;
+        }
+
+        auto zone = base + name + "/";
+
+        for(std::size_t i = 0;; ++i){
+            auto type = read_line(zone + "trip_point_" + std::to_string(i) + "_type");
+
+            if(type.empty()){
+                break;
+            }
+
+            if(type == "passive"){
+                zones.push_back({zone + "temp", std::strtol(read_line(zone + "trip_point_" + std::to_string(i) + "_temp").c_str(), nullptr, 10)});
+                break;
+            }
+        }
+    }
+
+    closedir(dir);
+
+    return zones;
+}
+
+//The CPUs of a sysfs list ("0-3,8")
+inline std::vector<std::size_t> parse_cpu_list(const std::string& list){
+    std::vector<std::size_t> cpus;
+
+    std::istringstream stream(list);
+    std::string range;
+
+    while(std::getline(stream, range, ',')){
+        if(range.empty()){
+            continue;
+        }
+
+        auto dash = range.find('-');
+        auto first = std::strtoul(range.c_str(), nullptr, 10);
+        auto last = dash == std::string::npos ? first : std::strtoul(range.c_str() + dash + 1, nullptr, 10);
+
+        for(auto cpu = first; cpu <= last; ++cpu){
+            cpus.push_back(cpu);
+        }
+    }
+
+    return cpus;
+}
+
+/*
+ * Select the CPU of the monitor threads: an allowed CPU other than the
+ * measurement core, preferably not one of its SMT siblings. Returns -1 if
+ * the process can only run on the measurement core.
+ */
+inline int monitor_cpu(int measure){
+    cpu_set_t allowed;
+    CPU_ZERO(&allowed);
+
+    if(sched_getaffinity(0, sizeof(allowed), &allowed) != 0){
+        return -1;
+    }
+
+    auto siblings = parse_cpu_list(read_line("/sys/devices/system/cpu/cpu" + std::to_string(measure) + "/topology/thread_siblings_list"));
+
+    int sibling = -1;
+
+    for(int cpu = CPU_SETSIZE - 1; cpu >= 0; --cpu){
+        if(cpu == measure || !CPU_ISSET(cpu, &allowed)){
+            continue;
+        }
+
+        if(std::find(siblings.begin(), siblings.end(), std::size_t(cpu)) == siblings.end()){
+            return cpu;
+        }
+
+        sibling = cpu;
+    }
+
+    return sibling;
+}
+
+inline void pin_current_thread(int cpu){
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+}
+
+} //end of namespace detail
+
+/*
+ * Monitor of the noise of the host during a measure. Two threads, pinned
+ * away from the measurement core, run between start() and stop():
+ *
+ *  - the sampler reads the activity of the other CPUs, the frequency, the
+ *    thermal state and the interrupts of the measurement core every period
+ *  - the hiccup detector sleeps for a short interval and measures how late
+ *    the system wakes it up
+ *
+ * The calling thread is pinned to the measurement core in the meantime and
+ * its affinity is restored by stop(), which must be called from the same
+ * thread. Each anomaly is recorded as a disturbance covering the period in
+ * which it was observed, the samples overlapping a disturbance are then
+ * flagged.
+ */
+struct noise_monitor {
+    std::size_t period = 10;         //Sampling period, in ms
+    std::size_t hiccup_interval = 1; //Sleep interval of the hiccup detector, in ms
+    std::size_t hiccup = 500;        //Wake-up delay considered as a hiccup, in us
+    double activity = 0.5;           //Busy fraction of the other CPUs considered as activity
+    double frequency_drop = 0.1;     //Relative drop of the frequency considered as a drop
+    std::size_t interrupts = 0;      //Number of interrupts per period tolerated on the measurement core
+
+    noise_monitor() = default;
+
+    noise_monitor(const noise_monitor&) = delete;
+    noise_monitor& operator=(const noise_monitor&) = delete;
+
+    ~noise_monitor(){
+        stop();
+    }
+
+    //Start monitoring the core of the calling thread, false if there is no other core to monitor from
+    bool start(){
+        stop();
+
+        measure_cpu = sched_getcpu();
+        watcher_cpu = measure_cpu < 0 ? -1 : detail::monitor_cpu(measure_cpu);
+
+        if(watcher_cpu < 0){
+            return false;
+        }
+
+        //The measures stay on the monitored core until stop()
+        pinned = pthread_getaffinity_np(pthread_self(), sizeof(affinity), &affinity) == 0;
+
+        if(pinned){
+            detail::pin_current_thread(measure_cpu);
+        }
+
+        if(zones_pending){
+            zones = detail::read_thermal_zones();
+            zones_pending = false;
+        }
+
+        samples.clear();
+        hiccups.clear();
+
+        running = true;
+
+        sampler = std::thread([this](){ sample(); });
+        detector = std::thread([this](){ detect_hiccups(); });
+
+        return true;
+    }
+
+    //Stop the monitor, the disturbances of the window are then available
+    void stop(){
+        if(!running){
+            return;
+        }
+
+        running = false;
+
+        sampler.join();
+        detector.join();
+
+        window.clear();
+        window.insert(window.end(), samples.begin(), samples.end());
+        window.insert(window.end(), hiccups.begin(), hiccups.end());
+
+        //The measures moved to another core, the whole window is suspect
+        if(sched_getcpu() != measure_cpu){
+            window.push_back({timer_clock::time_point::min(), timer_clock::time_point::max(), NOISE_MIGRATION});
+        }
+
+        if(pinned){
+            pthread_setaffinity_np(pthread_self(), sizeof(affinity), &affinity);
+            pinned = false;
+        }
+
+        std::sort(window.begin(), window.end(), [](const disturbance& lhs, const disturbance& rhs){ return lhs.begin < rhs.begin; });
+    }
+
+    //The disturbances of the last window, sorted by beginning
+    const std::vector<disturbance>& disturbances() const {
+        return window;
+    }
+
+    //The causes of all the disturbances of the last window
+    std::uint32_t causes() const {
+        std::uint32_t result = 0;
+
+        for(auto& d : window){
+            result |= d.causes;
+        }
+
+        return result;
+    }
+
+    //Flag the samples of the last window overlapping a disturbance, the samples are given by their start and duration (ns)
+    std::vector<bool> disturbed(const std::vector<timer_clock::time_point>& starts, const std::vector<std::size_t>& durations) const {
+        std::vector<bool> flags(starts.size(), false);
+
+        for(std::size_t i = 0; i < starts.size(); ++i){
+            auto end = starts[i] + clock_resolution(durations[i]);
+
+            for(auto& d : window){
+                if(d.begin > end){
+                    break;
+                }
+
+                if(d.end >= starts[i]){
+                    flags[i] = true;
+                    break;
+                }
+            }
+        }
+
+        return flags;
+    }
+
+    int measure_core() const {
+        return measure_cpu;
+    }
+
+    int monitor_core() const {
+        return watcher_cpu;
+    }
+
+private:
+    void sample(){
+        detail::pin_current_thread(watcher_cpu);
+
+        auto cpu = std::size_t(measure_cpu);
+
+        auto times = detail::read_cpu_times();
+        auto threads = detail::read_thread_times();
+        auto interrupts_count = detail::read_interrupts(cpu);
+        auto throttles = detail::read_throttle_count(cpu);
+        auto max_frequency = detail::read_cpu_frequency(cpu);
+
+        auto last = timer_clock::now();
+
+        while(running){
+            std::this_thread::sleep_for(std::chrono::milliseconds(period));
+
+            auto now = timer_clock::now();
+
+            std::uint32_t causes = 0;
+
+            //1. Activity of the other CPUs and time stolen from the measurement core
+
+            auto next_times = detail::read_cpu_times();
+            auto next_threads = detail::read_thread_times();
+
+            std::uint64_t busy = 0;
+            std::uint64_t total = 0;
+
+            for(std::size_t i = 0; i < std::min(times.size(), next_times.size()); ++i){
+                if(i == cpu){
+                    if(next_times[i].stolen > times[i].stolen){
+                        causes |= NOISE_ACTIVITY;
+                    }
+                } else if(int(i) != watcher_cpu){
+                    busy += next_times[i].busy - times[i].busy;
+                    total += next_times[i].total - times[i].total;
+                }
+            }
+
+            //The threads of the benchmark itself (a parallel bench, the workers of the pool, ...) are not a disturbance
+            std::uint64_t own = 0;
+
+            for(auto& thread : next_threads){
+                if(thread.second.cpu != measure_cpu && thread.second.cpu != watcher_cpu){
+                    auto previous = threads.find(thread.first);
+                    own += thread.second.ticks - (previous == threads.end() ? 0 : std::min(previous->second.ticks, thread.second.ticks));
+                }
+            }
+
+            busy -= std::min(busy, own);
+
+            if(total && double(busy) / total > activity){
+                causes |= NOISE_ACTIVITY;
+            }
+
+            times = std::move(next_times);
+            threads = std::move(next_threads);
+
+            //2. Frequency of the measurement core
+
+            auto frequency = detail::read_cpu_frequency(cpu);
+
+            if(frequency && frequency < (1.0 - frequency_drop) * max_frequency){
+                causes |= NOISE_FREQUENCY;
+            }
+
+            max_frequency = std::max(max_frequency, frequency);
+
+            //3. Thermal throttling
+
+            auto next_throttles = detail::read_throttle_count(cpu);
+
+            if(next_throttles > throttles){
+                causes |= NOISE_THERMAL;
+            }
+
+            throttles = next_throttles;
+
+            for(auto& zone : zones){
+                if(std::strtol(detail::read_line(zone.temperature).c_str(), nullptr, 10) >= zone.passive){
+                    causes |= NOISE_THERMAL;
+                }
+            }
+
+            //4. Interrupts of the measurement core
+
+            auto next_interrupts = detail::read_interrupts(cpu);
+
+            if(next_interrupts > interrupts_count + interrupts){
+                causes |= NOISE_INTERRUPTS;
+            }
+
+            interrupts_count = next_interrupts;
+
+            if(causes){
+                samples.push_back({last, now, causes});
+            }
+
+            last = now;
+        }
+    }
+
+    void detect_hiccups(){
+        detail::pin_current_thread(watcher_cpu);
+
+        const auto interval = std::chrono::milliseconds(hiccup_interval);
+        const auto tolerance = std::chrono::microseconds(hiccup);
+
+        while(running){
+            auto before = timer_clock::now();
+            std::this_thread::sleep_for(interval);
+            auto after = timer_clock::now();
+
+            if(after - before > interval + tolerance){
+                hiccups.push_back({before + interval, after, NOISE_HICCUP});
+            }
+        }
+    }
+
+    int measure_cpu = -1;
+    int watcher_cpu = -1;
+
+    cpu_set_t affinity;  //Affinity of the measuring thread before start()
+    bool pinned = false;
+
+    std::vector<detail::thermal_zone> zones;
+    bool zones_pending = true;
+
+    std::atomic<bool> running{false};
+    std::thread sampler;
+    std::thread detector;
+
+    //Written by the threads, read after they are joined
+    std::vector<disturbance> samples;
+    std::vector<disturbance> hiccups;
+
+    std::vector<disturbance> window;
+};
+
+} //end of namespace cpm
+
+#endif //CPM_NOISE_HPP
@@ -0,0 +1,237 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_PARALLEL_HPP
+#define CPM_PARALLEL_HPP
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <exception>
+#include <vector>
+#include <set>
+#include <string>
+#include <fstream>
+#include <algorithm>
+
+namespace cpm {
+
+#ifndef CPM_PARALLEL_GRAIN
+#define CPM_PARALLEL_GRAIN 1024
+#endif
+
+namespace detail {
+
+inline bool read_sysfs_value(const std::string& path, std::size_t& value){
+    std::ifstream stream(path);
+    return static_cast<bool>(stream >> value);
+}
+
+} //end of namespace detail
+
+// Return the number of physical cores of the machine.
+// The topology is read from sysfs, counting each (package, core) pair once,
+// so that SMT siblings are not counted. If the topology is not available,
+// the number of hardware threads is returned.
+inline std::size_t physical_cores(){
+    std::set<std::pair<std::size_t, std::size_t>> cores;
+
+    const std::size_t threads = std::max(1U, std::thread::hardware_concurrency());
+
+    //Offline CPUs have no topology, the numbering may therefore have holes
+    for(std::size_t cpu = 0; cpu < 4 * threads; ++cpu){
+        auto base = std::string("/sys/devices/system/cpu/cpu") + std::to_string(cpu) + "/topology/";
+
+        std::size_t package;
+        std::size_t core;
+        if(detail::read_sysfs_value(base + "physical_package_id", package) && detail::read_sysfs_value(base + "core_id", core)){
+            cores.emplace(package, core);
+        }
+    }
+
+    if(cores.empty()){
+        return threads;
+    }
+
+    return cores.size();
+}
+
+#ifndef CPM_PARALLEL_THREADS
+#define CPM_PARALLEL_THREADS cpm::physical_cores()
+#endif
+
+// A pool of persistent threads executing chunked loops.
+// The calling thread takes part to the work, so a pool of n threads only
+// starts n - 1 workers. Only one loop can be executed at a time, loops are
+// not allowed to be nested. If a chunk throws, the remaining chunks are
+// skipped and the first exception is rethrown on the calling thread once
+// all the workers are done.
+struct worker_pool {
+    explicit worker_pool(std::size_t n){
+        n = std::max(std::size_t(1), n);
+
+        for(std::size_t i = 0; i < n - 1; ++i){
+            workers.emplace_back([this](){ work_loop(); });
+        }
+    }
+
+    worker_pool(const worker_pool&) = delete;
+    worker_pool& operator=(const worker_pool&) = delete;
+
+    ~worker_pool(){
+        {
+            std::lock_guard<std::mutex> l(lock);
+            stop = true;
+        }
+
+        start_condition.notify_all();
+
+        for(auto& worker : workers){
+            worker.join();
+        }
+    }
+
+    std::size_t size() const {
+        return workers.size() + 1;
+    }
+
+    // Call functor(first, last) on even chunks of [0, n), of at least grain
+    // iterations.
+    template<typename Functor>
+    void parallel_for(std::size_t n, Functor&& functor, std::size_t grain = CPM_PARALLEL_GRAIN){
+        if(!n){
+            return;
+        }
+
+        const std::size_t chunks = std::min(4 * size(), std::max(std::size_t(1), n / std::max(std::size_t(1), grain)));
+
+        if(chunks == 1 || workers.empty()){
+            functor(std::size_t(0), n);
+            return;
+        }
+
+        std::lock_guard<std::mutex> run_l(run_lock);
+
+        {
+            std::lock_guard<std::mutex> l(lock);
+
+            job_invoke  = [](void* context, std::size_t first, std::size_t last){ (*static_cast<std::decay_t<Functor>*>(context))(first, last); };
+            job_context = const_cast<void*>(static_cast<const void*>(&functor));
+            job_n       = n;
+            job_chunks  = chunks;
+            job_chunk   = (n + chunks - 1) / chunks;
+            next_chunk  = 0;
+            active      = workers.size();
+            job_error   = nullptr;
+
+            ++generation;
+        }
+
+        start_condition.notify_all();
+
+        work();
+
+        std::exception_ptr error;
+
+        {
+            std::unique_lock<std::mutex> l(lock);
+            done_condition.wait(l, [this](){ return active == 0; });
+            std::swap(error, job_error);
+        }
+
+        if(error){
+            std::rethrow_exception(error);
+        }
+    }
+
+private:
+    void work(){
+        std::size_t chunk;
+        while((chunk = next_chunk.fetch_add(1)) < job_chunks){
+            const std::size_t first = chunk * job_chunk;
+            const std::size_t last = std::min(job_n, first + job_chunk);
+
+            if(first < last){
+                try {
+                    job_invoke(job_context, first, last);
+                } catch (...){
+                    std::lock_guard<std::mutex> l(lock);
+
+                    if(!job_error){
+                        job_error = std::current_exception();
+                    }
+
+                    next_chunk = job_chunks;
+                }
+            }
+        }
+    }
+
+    void work_loop(){
+        std::size_t seen = 0;
+
+        while(true){
+            {
+                std::unique_lock<std::mutex> l(lock);
+                start_condition.wait(l, [this, seen](){ return stop || generation != seen; });
+
+                if(stop){
+                    return;
+                }
+
+                seen = generation;
+            }
+
+            work();
+
+            {
+                std::lock_guard<std::mutex> l(lock);
+                if(--active == 0){
+                    done_condition.notify_one();
+                }
+            }
+        }
+    }
+
+    std::vector<std::thread> workers;
+
+    std::mutex run_lock;
+    std::mutex lock;
+    std::condition_variable start_condition;
+    std::condition_variable done_condition;
+
+    std::size_t generation = 0;
+    std::size_t active = 0;
+    bool stop = false;
+
+    void (*job_invoke)(void*, std::size_t, std::size_t) = nullptr;
+    void* job_context = nullptr;
+    std::size_t job_n = 0;
+    std::size_t job_chunk = 0;
+    std::size_t job_chunks = 0;
+    std::atomic<std::size_t> next_chunk{0};
+    std::exception_ptr job_error;
+};
+
+// Return the shared pool, started on first use with CPM_PARALLEL_THREADS threads.
+inline worker_pool& default_pool(){
+    static worker_pool pool(CPM_PARALLEL_THREADS);
+    return pool;
+}
+
+// Call functor(first, last) on chunks of [0, n) using the shared pool.
+// This can be used from two-pass initialization functors to fill large
+// inputs in parallel.
+template<typename Functor>
+void parallel_for(std::size_t n, Functor&& functor, std::size_t grain = CPM_PARALLEL_GRAIN){
+    default_pool().parallel_for(n, std::forward<Functor>(functor), grain);
+}
+
+} //end of namespace cpm
+
+#endif //CPM_PARALLEL_HPP
@@ -9,12 +9,32 @@
 #define CPM_POLICY_HPP
 
 #include <array>
+#include <string>
+#include <vector>
+#include <cmath>
+#include <type_traits>
+#include <algorithm>
 
 #include "duration.hpp"
 #include "compat.hpp"
+#include "topology.hpp"
 
 namespace cpm {
 
+//Conversions of one dimension of a size, overloaded for non-integral dimensions
+
+inline std::string dimension_to_string(std::size_t d){
+    return std::to_string(d);
+}
+
+inline std::size_t dimension_to_eff(std::size_t d){
+    return d;
+}
+
+inline std::string dimension_to_json(std::size_t d){
+    return std::to_string(d);
+}
+
 namespace detail {
 
 template<typename H>
@@ -59,7 +79,7 @@ struct tuple_to_string;
 template<typename Tuple, std::size_t... I>
 struct tuple_to_string <Tuple, std::index_sequence<I...>> {
     static std::string value(Tuple d){
-        std::array<std::string, std::tuple_size<Tuple>::value> values {{std::to_string(std::get<I>(d))...}};
+        std::array<std::string, std::tuple_size<Tuple>::value> values {{dimension_to_string(std::get<I>(d))...}};
         std::string acc = values[0];
         for(std::size_t i = 1; i < values.size(); ++i){
             acc += "x" + values[i];
@@ -74,7 +94,7 @@ struct tuple_to_eff;
 template<typename Tuple, std::size_t... I>
 struct tuple_to_eff <Tuple, std::index_sequence<I...>> {
     static std::size_t value(Tuple d){
-        std::array<std::size_t, std::tuple_size<Tuple>::value> values {{std::get<I>(d)...}};
+        std::array<std::size_t, std::tuple_size<Tuple>::value> values {{dimension_to_eff(std::get<I>(d))...}};
         std::size_t acc = values[0];
         for(std::size_t i = 1; i < values.size(); ++i){
             acc *= values[i];
@@ -83,6 +103,68 @@ struct tuple_to_eff <Tuple, std::index_sequence<I...>> {
     }
 };
 
+template<typename Tuple, typename Sequence>
+struct tuple_to_coordinates;
+
+template<typename Tuple, std::size_t... I>
+struct tuple_to_coordinates <Tuple, std::index_sequence<I...>> {
+    static std::vector<std::string> value(Tuple d){
+        return {dimension_to_json(std::get<I>(d))...};
+    }
+};
+
+//Policies with a custom_run member drive the measures themselves through
+//their run(measure) function instead of begin/has_next/next
+
+template<typename Policy, typename = void>
+struct has_custom_run : std::false_type {};
+
+template<typename Policy>
+struct has_custom_run<Policy, std::enable_if_t<Policy::custom_run>> : std::true_type {};
+
+//Policies with a sort_sizes member may measure the sizes out of order
+//and need their results to be sorted by effective size
+
+template<typename Policy, typename = void>
+struct sorts_sizes : std::false_type {};
+
+template<typename Policy>
+struct sorts_sizes<Policy, std::enable_if_t<Policy::sort_sizes>> : std::true_type {};
+
+//Policies with a select_title member choose their sizes from the title
+//of the bench, through their select(title) function
+
+template<typename Policy, typename = void>
+struct selects_title : std::false_type {};
+
+template<typename Policy>
+struct selects_title<Policy, std::enable_if_t<Policy::select_title>> : std::true_type {};
+
+template<typename Policy, std::enable_if_t<selects_title<Policy>::value, int> = 42>
+void select_title(const std::string& title){
+    Policy::select(title);
+}
+
+template<typename Policy, std::enable_if_t<!selects_title<Policy>::value, int> = 42>
+void select_title(const std::string& /*title*/){}
+
+//Policies with a regime(d) function label each size (cache regime for instance)
+
+template<typename Policy, typename Tuple>
+auto size_regime(Tuple d, int) -> decltype(std::string(Policy::regime(d))) {
+    return Policy::regime(d);
+}
+
+template<typename Policy, typename Tuple>
+std::string size_regime(Tuple /*d*/, long){
+    return {};
+}
+
+template<typename Policy, typename Tuple>
+std::string size_regime(Tuple d){
+    return size_regime<Policy>(d, 0);
+}
+
 } //end of namespace detail
 
 enum class stop_policy {
@@ -91,7 +173,97 @@ enum class stop_policy {
 };
 
 enum class nary_combination_policy {
-    PARALLEL
+    PARALLEL, //The sub-policies are advanced in lockstep
+    CARTESIAN //The full grid of the sub-policies is enumerated
+};
+
+//Pruning predicate keeping all the points of the grid
+struct no_pruning {
+    template<typename Tuple>
+    bool operator()(const Tuple& /*d*/) const {
+        return false;
+    }
+};
+
+namespace detail {
+
+/*
+ * Enumerate the dimension I of a grid and recurse on the next ones.
+ * Each dimension is driven by its own policy. The duration given to
+ * has_next is the cheapest measure of the sub-grid, so that a timeout
+ * policy abandons a row as soon as it is exceeded and an outer timeout
+ * policy stops once even the cheapest point of a row is too slow.
+ */
+template<std::size_t I, std::size_t N, typename Prune, typename... Policy>
+struct cartesian_run {
+    using policy = typename nth_type<I, Policy...>::type;
+
+    template<typename Tuple, typename Measure>
+    static bool value(Tuple& d, Measure& measure, measure_result& cheapest){
+        bool measured = false;
+
+        std::size_t i = 0;
+        std::get<I>(d) = policy::begin();
+
+        while(true){
+            measure_result duration{};
+
+            if(cartesian_run<I + 1, N, Prune, Policy...>::value(d, measure, duration)){
+                if(!measured || duration.mean < cheapest.mean){
+                    cheapest = duration;
+                }
+
+                measured = true;
+            }
+
+            if(!policy::has_next(i, std::get<I>(d), duration)){
+                break;
+            }
+
+            std::get<I>(d) = policy::next(i, std::get<I>(d));
+            ++i;
+        }
+
+        return measured;
+    }
+};
+
+template<std::size_t N, typename Prune, typename... Policy>
+struct cartesian_run<N, N, Prune, Policy...> {
+    template<typename Tuple, typename Measure>
+    static bool value(Tuple& d, Measure& measure, measure_result& duration){
+        if(Prune()(static_cast<const Tuple&>(d))){
+            return false;
+        }
+
+        duration = measure(d);
+
+        return true;
+    }
+};
+
+} //end of namespace detail
+
+/*
+ * Cartesian policy: measure every point of the grid of the sub-policies,
+ * the last dimension varying first. The points for which Prune returns
+ * true are skipped.
+ */
+template<typename Prune, typename... Policy>
+struct pruned_cartesian_policy {
+    static constexpr bool custom_run = true;
+
+    template<typename T = int> //Simply to fake debug symbols for auto
+    static cpp14_constexpr auto begin(){
+        return std::make_tuple(Policy::begin()...);
+    }
+
+    template<typename Measure>
+    static void run(Measure&& measure){
+        auto d = begin();
+        measure_result duration{};
+        detail::cartesian_run<0, sizeof...(Policy), Prune, Policy...>::value(d, measure, duration);
+    }
 };
 
 template<std::size_t S, std::size_t E, std::size_t A, std::size_t M, stop_policy SP>
@@ -126,8 +298,179 @@ struct values_policy {
     }
 };
 
+/*
+ * Adaptive policy: first a geometric sweep from S to E (multiplying by M),
+ * then up to B additional sizes bisecting (geometrically) the pair of
+ * adjacent sizes with the largest relative change in throughput per
+ * element, as long as this change is above T percent. If TB is not zero,
+ * no refinement is started after TB milliseconds.
+ */
+template<std::size_t S, std::size_t E, std::size_t M = 10, std::size_t T = 20, std::size_t B = 16, std::size_t TB = 0>
+struct adaptive_policy {
+    static_assert(S > 0 && M > 1, "adaptive_policy needs a positive start and a multiplier greater than one");
+
+    static constexpr bool custom_run = true;
+    static constexpr bool sort_sizes = true;
+
+    static constexpr std::size_t begin(){
+        return S;
+    }
+
+    template<typename Measure>
+    static void run(Measure&& measure){
+        auto start_time = timer_clock::now();
+
+        std::vector<std::pair<std::size_t, double>> points;
+
+        //1. Coarse sweep
+
+        for(std::size_t d = S; d <= E; d *= M){
+            auto duration = measure(d);
+            points.emplace_back(d, duration.throughput_e);
+
+            if(d > E / M){
+                break;
+            }
+        }
+
+        //2. Refinement around the cliffs
+
+        for(std::size_t r = 0; r < B; ++r){
+            if(TB && std::chrono::duration_cast<millseconds>(timer_clock::now() - start_time).count() >= static_cast<long>(TB)){
+                break;
+            }
+
+            std::size_t cliff = 0;
+            double cliff_change = T / 100.0;
+
+            for(std::size_t i = 1; i < points.size(); ++i){
+                auto& a = points[i - 1];
+                auto& b = points[i];
+
+                auto max = std::max(a.second, b.second);
+
+                if(b.first - a.first < 2 || max <= 0.0){
+                    continue;
+                }
+
+                auto change = std::abs(b.second - a.second) / max;
+
+                if(change > cliff_change){
+                    cliff = i;
+                    cliff_change = change;
+                }
+            }
+
+            if(!cliff){
+                break;
+            }
+
+            auto a = points[cliff - 1].first;
+            auto b = points[cliff].first;
+
+            auto d = static_cast<std::size_t>(std::sqrt(static_cast<double>(a) * b) + 0.5);
+            d = std::min(b - 1, std::max(a + 1, d));
+
+            auto duration = measure(d);
+            points.emplace(points.begin() + cliff, d, duration.throughput_e);
+        }
+    }
+};
+
+//Working set of B bytes per element
+template<std::size_t B>
+struct bytes_per_element {
+    std::size_t operator()(std::size_t n) const {
+        return n * B;
+    }
+};
+
+/*
+ * Cache policy: the sizes are chosen so that the working set, given in
+ * bytes by F{}(n), is at fractions and multiples of each level of data
+ * cache of the host and finally in DRAM. Each size is labeled with the
+ * regime holding its working set.
+ */
+template<typename F>
+struct cache_policy {
+    static const std::vector<std::size_t>& sizes(){
+        static const std::vector<std::size_t> values = compute_sizes();
+        return values;
+    }
+
+    static std::size_t begin(){
+        return sizes()[0];
+    }
+
+    static bool has_next(std::size_t i, std::size_t /*d*/, measure_result /*duration*/){
+        return (i + 1) < sizes().size();
+    }
+
+    static std::size_t next(std::size_t i, std::size_t /*d*/){
+        return sizes()[i+1];
+    }
+
+    static std::string regime(std::size_t d){
+        return cache_regime(F{}(d));
+    }
+
+private:
+    //Smallest n with a working set of at least the given bytes
+    static std::size_t size_for(std::size_t bytes){
+        F f;
+
+        std::size_t high = 1;
+        while(f(high) < bytes){
+            high *= 2;
+        }
+
+        std::size_t low = high / 2 + 1;
+        while(low < high){
+            auto mid = low + (high - low) / 2;
+            if(f(mid) < bytes){
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+
+        return high;
+    }
+
+    static std::vector<std::size_t> compute_sizes(){
+        std::vector<std::size_t> targets;
+
+        for(auto& cache : data_caches()){
+            targets.push_back(cache.size / 4);
+            targets.push_back(cache.size / 2);
+            targets.push_back(3 * (cache.size / 4));
+        }
+
+        auto last = data_caches().back().size;
+        targets.push_back(2 * last);
+        targets.push_back(4 * last);
+        targets.push_back(16 * last);
+
+        std::vector<std::size_t> values;
+        for(auto bytes : targets){
+            values.push_back(size_for(std::max(std::size_t(1), bytes)));
+        }
+
+        std::sort(values.begin(), values.end());
+        values.erase(std::unique(values.begin(), values.end()), values.end());
+
+        return values;
+    }
+};
+
 template<nary_combination_policy NCB, typename... Policy>
-struct nary_policy {
+struct nary_policy;
+
+template<typename... Policy>
+struct nary_policy<nary_combination_policy::CARTESIAN, Policy...> : pruned_cartesian_policy<no_pruning, Policy...> {};
+
+template<typename... Policy>
+struct nary_policy<nary_combination_policy::PARALLEL, Policy...> {
     template<typename T = int> //Simply to fake debug symbols for auto
     static cpp14_constexpr auto begin(){
         return std::make_tuple(Policy::begin()...);
@@ -150,6 +493,9 @@ using std_timeout_policy = increasing_policy<10, 1000, 0, 10, stop_policy::TIMEO
 template<typename... Policy>
 using simple_nary_policy = nary_policy<nary_combination_policy::PARALLEL, Policy...>;
 
+template<typename... Policy>
+using cartesian_policy = nary_policy<nary_combination_policy::CARTESIAN, Policy...>;
+
 inline std::string size_to_string(std::size_t t){
     return std::to_string(t);
 }
@@ -168,6 +514,17 @@ std::size_t size_to_eff(Tuple t){
     return detail::tuple_to_eff<Tuple, std::make_index_sequence<std::tuple_size<Tuple>::value>>::value(t);;
 }
 
+//The coordinates of multi-dimensional sizes, as JSON values
+
+inline std::vector<std::string> size_to_coordinates(std::size_t /*t*/){
+    return {};
+}
+
+template<typename Tuple>
+std::vector<std::string> size_to_coordinates(Tuple t){
+    return detail::tuple_to_coordinates<Tuple, std::make_index_sequence<std::tuple_size<Tuple>::value>>::value(t);
+}
+
 } //end of namespace cpm
 
 #endif //CPM_POLICY_HPP
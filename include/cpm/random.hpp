@@ -11,54 +11,41 @@
 #include <random>
 
 #ifdef CPM_PARALLEL_RANDOMIZE
-#include <thread>
-#include <future>
+#include "parallel.hpp"
 #endif
 
 namespace cpm {
 
 #ifndef CPM_PARALLEL_THRESHOLD
-#define CPM_PARALLEL_THRESHOLD 10000
-#endif
-
-#ifndef CPM_PARALLEL_THREADS
-//We are assuming Hyper-Threading by default
-#define CPM_PARALLEL_THREADS std::thread::hardware_concurrency() / 2
+#define CPM_PARALLEL_THRESHOLD 4096
 #endif
 
 #ifdef CPM_PARALLEL_RANDOMIZE
 
 #ifndef CPM_FAST_RANDOMIZE
 
+namespace detail {
+
+//Each thread of the pool needs its own engine
+inline std::mt19937_64& thread_engine(){
+    thread_local std::random_device rd;
+    thread_local std::mt19937_64 rand_engine(rd());
+    return rand_engine;
+}
+
+} //end of namespace detail
+
 template<typename T>
 void randomize_double(T& container){
     if(container.size() > CPM_PARALLEL_THRESHOLD){
-        const std::size_t n = CPM_PARALLEL_THREADS; //We are assuming Hyper-Threading
-        const std::size_t p = container.size() / n;
-
-        std::vector<std::future<void>> futures;
-
-        for(std::size_t i = 0; i < n; ++i){
-            futures.push_back(std::async(std::launch::async, [&](std::size_t ii){
-                static std::random_device rd;
-                static std::mt19937_64 rand_engine(rd());
-                static std::uniform_real_distribution<double> real_distribution(-10000.0, 10000.0);
-                static auto generator = std::bind(real_distribution, rand_engine);
-
-                for(std::size_t j = p * ii; j < p * (ii + 1); ++j){
-                    container[j] = generator();
-                }
-                }, i));
-        }
-
-        static std::random_device rd;
-        static std::mt19937_64 rand_engine(rd());
-        static std::uniform_real_distribution<double> real_distribution(-10000.0, 10000.0);
-        static auto generator = std::bind(real_distribution, rand_engine);
-
-        for(std::size_t j = container.size() - container.size() % p; j < container.size(); ++j){
-            container[j] = generator();
-        }
+        parallel_for(container.size(), [&container](std::size_t first, std::size_t last){
+            auto& rand_engine = detail::thread_engine();
+            std::uniform_real_distribution<double> real_distribution(-10000.0, 10000.0);
+
+            for(std::size_t j = first; j < last; ++j){
+                container[j] = real_distribution(rand_engine);
+            }
+        });
     } else {
         static std::random_device rd;
         static std::mt19937_64 rand_engine(rd());
@@ -85,22 +72,11 @@ void randomize_double(T& container){
     const auto c = generator();
 
     if(container.size() > CPM_PARALLEL_THRESHOLD){
-        const std::size_t n = CPM_PARALLEL_THREADS; //We are assuming Hyper-Threading
-        const std::size_t p = container.size() / n;
-
-        std::vector<std::future<void>> futures;
-
-        for(std::size_t i = 0; i < n; ++i){
-            futures.push_back(std::async(std::launch::async, [&](std::size_t ii){
-                for(std::size_t j = p * ii; j < p * (ii + 1); ++j){
-                    container[j] = a + (j * b) + (-j * c);
-                }
-                }, i));
-        }
-
-        for(std::size_t j = container.size() - container.size() % p; j < container.size(); ++j){
-            container[j] = a + (j * b) + (-j * c);
-        }
+        parallel_for(container.size(), [&container, a, b, c](std::size_t first, std::size_t last){
+            for(std::size_t j = first; j < last; ++j){
+                container[j] = a + (j * b) + (-j * c);
+            }
+        });
     } else {
         std::size_t i = 0;
         for(auto& v : container){
@@ -15,17 +15,22 @@ namespace cpm {
 
 struct raw_theme {
     const cpm::reports_data& data;
+    const report_page& page;
     cxxopts::Options& options;
-    std::ostream& stream;
+    page_buffer& stream;
 
     std::string current_compiler;
     std::string current_configuration;
 
-    raw_theme(const reports_data& data, cxxopts::Options& options, std::ostream& stream, std::string compiler, std::string configuration)
-        : data(data), options(options), stream(stream), current_compiler(std::move(compiler)), current_configuration(std::move(configuration)) {}
+    raw_theme(const reports_data& data, const report_page& page, cxxopts::Options& options, page_buffer& stream, std::string compiler, std::string configuration)
+        : data(data), page(page), options(options), stream(stream), current_compiler(std::move(compiler)), current_configuration(std::move(configuration)) {}
 
     void include(){}
-    void header(){}
+    void header(){
+        stream << "<div><input id=\"cpm_search\" type=\"text\" placeholder=\"Search\" autocomplete=\"off\">\n";
+        stream << "<ul id=\"cpm_search_results\" style=\"display: none;\"></ul></div>\n";
+        stream << "<div><a href=\"regressions.html\">Regressions</a></div>\n";
+    }
     void footer(){}
 
     void before_information(std::string name){
@@ -65,7 +70,7 @@ struct raw_theme {
 
     void after_graph(){}
 
-    void before_result(const std::string& title, bool /*sub */, const std::vector<cpm::document_cref>& /*documents*/){
+    void before_result(const std::string& title, bool /*sub */, const std::vector<std::size_t>& /*runs*/){
         stream << "<h2 style=\"clear:both\">" << title << "</h2>\n";
     }
 
@@ -97,6 +102,14 @@ struct raw_theme {
         stream << "</table>\n";
     }
 
+    void before_regressions(){
+        stream << "<table>\n";
+    }
+
+    void after_regressions(){
+        stream << "</table>\n";
+    }
+
     void cell(const std::string& v){
         stream << "<td>" << v << "</td>\n";
     }
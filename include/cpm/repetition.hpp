@@ -0,0 +1,296 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_REPETITION_HPP
+#define CPM_REPETITION_HPP
+
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstdlib>
+#include <algorithm>
+#include <iostream>
+
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/stat.h>
+
+#include "duration.hpp"
+#include "statistics.hpp"
+
+extern char** environ;
+
+namespace cpm {
+
+/*
+ * Layout of the memory of a repetition: the size of the padding added to
+ * the environment (which moves the initial stack), the offset of the stack
+ * of the benches and the size of the block allocated before the benches.
+ */
+struct repetition_layout {
+    std::size_t env_padding;
+    std::size_t stack_offset;
+    std::size_t heap_offset;
+};
+
+//The numeric value of the environment variable, 0 if not set
+inline std::size_t layout_value(const char* name){
+    auto value = std::getenv(name);
+    return value ? std::strtoull(value, nullptr, 10) : 0;
+}
+
+//The results folder of the current process if it is a repetition, nullptr otherwise
+inline const char* repetition_folder(){
+    return std::getenv("CPM_REPETITION_FOLDER");
+}
+
+//Move the next allocations of the heap with a block that is never freed
+inline void pad_heap(std::size_t bytes){
+    static void* volatile padding = nullptr;
+
+    if(bytes && !padding){
+        padding = std::malloc(bytes);
+    }
+}
+
+//Variance of the samples of a point, split between the processes
+struct variance_components {
+    double within;  //Variance of the samples within a process
+    double between; //Variance of the means of the processes caused by the process (layout, ...)
+};
+
+/*
+ * One-way random effects decomposition of the variance of the repetitions:
+ * the variance of the means of the processes is the variance between the
+ * processes plus the variance of the mean of each process (its standard
+ * error), which is recovered from its 95% confidence interval.
+ */
+inline variance_components decompose_variance(const std::vector<measure_result>& repetitions){
+    auto n = repetitions.size();
+
+    double mean = 0.0;
+    double within = 0.0;
+    double errors = 0.0;
+
+    for(auto& r : repetitions){
+        mean += r.mean;
+        within += r.stddev * r.stddev;
+
+        double stderror = (r.mean_ub - r.mean) / 1.96;
+        errors += stderror * stderror;
+    }
+
+    mean /= n;
+    within /= n;
+    errors /= n;
+
+    if(n < 2){
+        return {within, 0.0};
+    }
+
+    double means = 0.0;
+    for(auto& r : repetitions){
+        means += (r.mean - mean) * (r.mean - mean);
+    }
+    means /= (n - 1);
+
+    return {within, std::max(0.0, means - errors)};
+}
+
+/*
+ * Combine the measures of a point in several processes. The mean is the
+ * mean of the processes and its confidence interval comes from the spread
+ * of the means of the processes, the processes are the samples. The
+ * standard deviation includes both the variance within and between the
+ * processes.
+ */
+inline measure_result combine_repetitions(const std::vector<measure_result>& repetitions, std::size_t size_eff){
+    auto n = repetitions.size();
+
+    measure_result result = repetitions.front();
+
+    if(n < 2){
+        return result;
+    }
+
+    auto components = decompose_variance(repetitions);
+
+    double mean = 0.0;
+    double noise = 0.0;
+    std::size_t monitored = 0;
+
+    for(auto& r : repetitions){
+        mean += r.mean;
+
+        result.min = std::min(result.min, r.min);
+        result.max = std::max(result.max, r.max);
+
+        if(r.noise >= 0.0){
+            noise += r.noise;
+            ++monitored;
+        }
+    }
+
+    mean /= n;
+
+    double means = 0.0;
+    for(auto& r : repetitions){
+        means += (r.mean - mean) * (r.mean - mean);
+    }
+    means /= (n - 1);
+
+    double stderror = std::sqrt(means / n);
+    double q = student_quantile(0.975, n - 1);
+
+    result.mean = mean;
+    result.mean_lb = mean - q * stderror;
+    result.mean_ub = mean + q * stderror;
+    result.stddev = std::sqrt(components.within + components.between);
+    result.noise = monitored ? noise / monitored : -1.0;
+
+    result.update(size_eff);
+
+    return result;
+}
+
+//Remove a folder and its content
+inline void remove_folder(const std::string& folder){
+    if(DIR* dir = opendir(folder.c_str())){
+        while(auto entry = readdir(dir)){
+            std::string name = entry->d_name;
+
+            if(name == "." || name == ".."){
+                continue;
+            }
+
+            auto path = folder + "/" + name;
+
+            struct stat buffer;
+            if(lstat(path.c_str(), &buffer) == 0 && S_ISDIR(buffer.st_mode)){
+                remove_folder(path);
+            } else {
+                unlink(path.c_str());
+            }
+        }
+
+        closedir(dir);
+    }
+
+    rmdir(folder.c_str());
+}
+
+//The binary result files of the folder
+inline std::vector<std::string> binary_results(const std::string& folder){
+    std::vector<std::string> files;
+
+    if(DIR* dir = opendir(folder.c_str())){
+        while(auto entry = readdir(dir)){
+            std::string name = entry->d_name;
+
+            if(name.size() > 5 && name.compare(name.size() - 5, 5, ".cpmb") == 0){
+                files.push_back(folder + "/" + name);
+            }
+        }
+
+        closedir(dir);
+    }
+
+    return files;
+}
+
+/*
+ * Execute the benchmark again in n processes, one after the other, each
+ * with a random memory layout and its results saved in binary in its own
+ * folder of the given folder. The layouts are drawn from the seed. Returns
+ * the result file of each repetition, nothing if one of them failed.
+ */
+inline std::vector<std::string> run_repetitions(const std::vector<std::string>& arguments, std::size_t n, bool heap, const std::string& folder,
+                                                std::uint32_t seed, std::vector<repetition_layout>& layouts){
+    std::vector<std::string> files;
+
+    std::mt19937 generator(seed);
+    std::uniform_int_distribution<std::size_t> env_distribution(0, 4095);
+    std::uniform_int_distribution<std::size_t> stack_distribution(0, 255);
+    std::uniform_int_distribution<std::size_t> heap_distribution(0, 4095);
+
+    std::vector<char*> argv;
+    for(auto& argument : arguments){
+        argv.push_back(const_cast<char*>(argument.c_str()));
+    }
+    argv.push_back(nullptr);
+
+    for(std::size_t r = 0; r < n; ++r){
+        //The stack and the heap offsets keep the 16 bytes alignment
+        repetition_layout layout{env_distribution(generator), 16 * stack_distribution(generator), heap ? 16 * heap_distribution(generator) : 0};
+
+        auto results = folder + "/" + std::to_string(r);
+
+        if(mkdir(results.c_str(), 0777)){
+            std::cout << "cpm: Failed to create the folder " << results << std::endl;
+            return {};
+        }
+
+        std::vector<std::string> variables;
+
+        for(char** e = environ; *e; ++e){
+            std::string variable = *e;
+
+            if(variable.compare(0, 15, "CPM_REPETITION_") != 0 && variable.compare(0, 11, "CPM_LAYOUT_") != 0){
+                variables.push_back(variable);
+            }
+        }
+
+        variables.push_back("CPM_REPETITION_FOLDER=" + results);
+        variables.push_back("CPM_LAYOUT_STACK=" + std::to_string(layout.stack_offset));
+        variables.push_back("CPM_LAYOUT_HEAP=" + std::to_string(layout.heap_offset));
+        variables.push_back("CPM_LAYOUT_PADDING=" + std::string(layout.env_padding, 'x'));
+
+        std::vector<char*> envp;
+        for(auto& variable : variables){
+            envp.push_back(const_cast<char*>(variable.c_str()));
+        }
+        envp.push_back(nullptr);
+
+        std::cout << "cpm: Repetition " << (r + 1) << "/" << n << " (environment padding " << layout.env_padding
+            << ", stack offset " << layout.stack_offset << ", heap offset " << layout.heap_offset << ")" << std::endl;
+
+        auto pid = fork();
+
+        if(pid < 0){
+            std::cout << "cpm: Failed to start the repetition" << std::endl;
+            return {};
+        }
+
+        if(pid == 0){
+            execve("/proc/self/exe", argv.data(), envp.data());
+            execve(argv[0], argv.data(), envp.data());
+            _exit(127);
+        }
+
+        int status = 0;
+        waitpid(pid, &status, 0);
+
+        auto result = binary_results(results);
+
+        if(!WIFEXITED(status) || WEXITSTATUS(status) != 0 || result.size() != 1){
+            std::cout << "cpm: The repetition " << (r + 1) << " failed" << std::endl;
+            return {};
+        }
+
+        files.push_back(result.front());
+        layouts.push_back(layout);
+    }
+
+    return files;
+}
+
+} //end of namespace cpm
+
+#endif //CPM_REPETITION_HPP
@@ -0,0 +1,217 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_RUNTIME_POLICY_HPP
+#define CPM_RUNTIME_POLICY_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <cctype>
+
+#include "policy.hpp"
+
+namespace cpm {
+
+//The sizes of the runtime policies, by bench title. The sizes with an
+//empty title are used for the benches without their own sizes.
+inline std::map<std::string, std::vector<std::size_t>>& runtime_sizes(){
+    static std::map<std::string, std::vector<std::size_t>> sizes;
+    return sizes;
+}
+
+namespace detail {
+
+inline bool parse_size_list(const std::string& list, std::vector<std::size_t>& sizes){
+    std::size_t i = 0;
+
+    while(i < list.size()){
+        std::size_t value = 0;
+        std::size_t digits = 0;
+
+        for(; i < list.size() && list[i] >= '0' && list[i] <= '9'; ++i, ++digits){
+            value = value * 10 + (list[i] - '0');
+        }
+
+        if(!digits || (i < list.size() && list[i] != ',')){
+            return false;
+        }
+
+        sizes.push_back(value);
+
+        ++i;
+    }
+
+    return !sizes.empty();
+}
+
+//Minimal reader for the sizes files: {"title": [1, 10, 100], ...}
+struct sizes_reader {
+    std::string source;
+    std::size_t i = 0;
+
+    void skip(){
+        while(i < source.size() && std::isspace(static_cast<unsigned char>(source[i]))){
+            ++i;
+        }
+    }
+
+    bool expect(char c){
+        skip();
+
+        if(i < source.size() && source[i] == c){
+            ++i;
+            return true;
+        }
+
+        return false;
+    }
+
+    bool read_string(std::string& value){
+        if(!expect('"')){
+            return false;
+        }
+
+        for(; i < source.size() && source[i] != '"'; ++i){
+            if(source[i] == '\\' && i + 1 < source.size()){
+                ++i;
+            }
+
+            value += source[i];
+        }
+
+        return expect('"');
+    }
+
+    bool read_number(std::size_t& value){
+        skip();
+
+        std::size_t digits = 0;
+        for(value = 0; i < source.size() && source[i] >= '0' && source[i] <= '9'; ++i, ++digits){
+            value = value * 10 + (source[i] - '0');
+        }
+
+        return digits > 0;
+    }
+
+    bool read(std::map<std::string, std::vector<std::size_t>>& sizes){
+        if(!expect('{')){
+            return false;
+        }
+
+        if(expect('}')){
+            return true;
+        }
+
+        do {
+            std::string title;
+            std::vector<std::size_t> values;
+
+            if(!read_string(title) || !expect(':') || !expect('[')){
+                return false;
+            }
+
+            do {
+                std::size_t value;
+                if(!read_number(value)){
+                    return false;
+                }
+                values.push_back(value);
+            } while(expect(','));
+
+            if(!expect(']')){
+                return false;
+            }
+
+            sizes[title] = std::move(values);
+        } while(expect(','));
+
+        return expect('}');
+    }
+};
+
+} //end of namespace detail
+
+//Add the sizes given as "title:1,10,100" or "1,10,100" for all the benches
+inline bool add_runtime_sizes(const std::string& spec){
+    auto colon = spec.rfind(':');
+
+    std::string title = colon == std::string::npos ? std::string() : spec.substr(0, colon);
+    std::string list = colon == std::string::npos ? spec : spec.substr(colon + 1);
+
+    std::vector<std::size_t> sizes;
+    if(!detail::parse_size_list(list, sizes)){
+        return false;
+    }
+
+    runtime_sizes()[title] = std::move(sizes);
+
+    return true;
+}
+
+//Add the sizes of a JSON file of the form {"title": [1, 10, 100], "": [1000]}
+inline bool load_runtime_sizes(const std::string& path){
+    std::ifstream stream(path);
+
+    if(!stream){
+        return false;
+    }
+
+    std::stringstream buffer;
+    buffer << stream.rdbuf();
+
+    detail::sizes_reader reader;
+    reader.source = buffer.str();
+
+    return reader.read(runtime_sizes()) && (reader.skip(), reader.i == reader.source.size());
+}
+
+/*
+ * Runtime policy: the sizes are taken from runtime_sizes() for the title of
+ * the bench, falling back to the sizes without title and then to the
+ * Fallback policy.
+ */
+template<typename Fallback = std_stop_policy>
+struct runtime_policy {
+    static constexpr bool select_title = true;
+
+    static void select(const std::string& title){
+        auto& sizes = runtime_sizes();
+
+        auto it = sizes.find(title);
+
+        if(it == sizes.end()){
+            it = sizes.find("");
+        }
+
+        current() = it == sizes.end() ? nullptr : &it->second;
+    }
+
+    static std::size_t begin(){
+        return current() ? (*current())[0] : Fallback::begin();
+    }
+
+    static bool has_next(std::size_t i, std::size_t d, measure_result duration){
+        return current() ? (i + 1) < current()->size() : Fallback::has_next(i, d, duration);
+    }
+
+    static std::size_t next(std::size_t i, std::size_t d){
+        return current() ? (*current())[i + 1] : Fallback::next(i, d);
+    }
+
+private:
+    static const std::vector<std::size_t>*& current(){
+        static const std::vector<std::size_t>* sizes = nullptr;
+        return sizes;
+    }
+};
+
+} //end of namespace cpm
+
+#endif //CPM_RUNTIME_POLICY_HPP
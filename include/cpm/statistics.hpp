@@ -0,0 +1,258 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_STATISTICS_HPP
+#define CPM_STATISTICS_HPP
+
+#include <cmath>
+#include <vector>
+#include <numeric>
+#include <algorithm>
+
+namespace cpm {
+
+namespace detail {
+
+//Continued fraction of the regularized incomplete beta function (modified Lentz)
+inline double beta_fraction(double a, double b, double x){
+    const double tiny = 1e-300;
+
+    double c = 1.0;
+    double d = 1.0 - (a + b) * x / (a + 1.0);
+
+    if(std::fabs(d) < tiny){
+        d = tiny;
+    }
+
+    d = 1.0 / d;
+    double h = d;
+
+    for(int m = 1; m <= 300; ++m){
+        double m2 = 2.0 * m;
+
+        double aa = m * (b - m) * x / ((a + m2 - 1.0) * (a + m2));
+
+        d = 1.0 + aa * d;
+        c = 1.0 + aa / c;
+
+        d = std::fabs(d) < tiny ? tiny : d;
+        c = std::fabs(c) < tiny ? tiny : c;
+
+        d = 1.0 / d;
+        h *= d * c;
+
+        aa = -(a + m) * (a + b + m) * x / ((a + m2) * (a + m2 + 1.0));
+
+        d = 1.0 + aa * d;
+        c = 1.0 + aa / c;
+
+        d = std::fabs(d) < tiny ? tiny : d;
+        c = std::fabs(c) < tiny ? tiny : c;
+
+        d = 1.0 / d;
+
+        double delta = d * c;
+        h *= delta;
+
+        if(std::fabs(delta - 1.0) < 1e-12){
+            break;
+        }
+    }
+
+    return h;
+}
+
+//Regularized incomplete beta function I_x(a, b)
+inline double incomplete_beta(double a, double b, double x){
+    if(x <= 0.0){
+        return 0.0;
+    }
+
+    if(x >= 1.0){
+        return 1.0;
+    }
+
+    double front = std::exp(std::lgamma(a + b) - std::lgamma(a) - std::lgamma(b) + a * std::log(x) + b * std::log(1.0 - x));
+
+    if(x < (a + 1.0) / (a + b + 2.0)){
+        return front * beta_fraction(a, b, x) / a;
+    } else {
+        return 1.0 - front * beta_fraction(b, a, 1.0 - x) / b;
+    }
+}
+
+} //end of namespace detail
+
+inline double normal_cdf(double z){
+    return 0.5 * std::erfc(-z / std::sqrt(2.0));
+}
+
+//Two-sided p-value of the Student t statistic with df degrees of freedom
+inline double student_p(double t, double df){
+    return detail::incomplete_beta(df / 2.0, 0.5, df / (df + t * t));
+}
+
+//Quantile of the Student distribution, found by bisection
+inline double student_quantile(double p, double df){
+    double low = 0.0;
+    double high = 1000.0;
+
+    //P(T <= t) = 1 - student_p(t) / 2 for t > 0
+    for(int i = 0; i < 200; ++i){
+        double middle = (low + high) / 2.0;
+
+        if(1.0 - student_p(middle, df) / 2.0 < p){
+            low = middle;
+        } else {
+            high = middle;
+        }
+    }
+
+    return (low + high) / 2.0;
+}
+
+struct test_result {
+    double statistic;
+    double df;      //Degrees of freedom, 0 for the tests without
+    double p_value; //Two-sided
+};
+
+/*
+ * Welch's t-test of the difference of two means with unequal variances,
+ * from the summaries of the samples.
+ */
+inline test_result welch_test(double mean_a, double stddev_a, double n_a, double mean_b, double stddev_b, double n_b){
+    double var_a = stddev_a * stddev_a / n_a;
+    double var_b = stddev_b * stddev_b / n_b;
+
+    if(var_a + var_b == 0.0){
+        return {0.0, 0.0, mean_a == mean_b ? 1.0 : 0.0};
+    }
+
+    double t = (mean_b - mean_a) / std::sqrt(var_a + var_b);
+
+    //Welch-Satterthwaite equation
+    double df = (var_a + var_b) * (var_a + var_b) / (var_a * var_a / std::max(n_a - 1.0, 1.0) + var_b * var_b / std::max(n_b - 1.0, 1.0));
+
+    return {t, df, student_p(t, df)};
+}
+
+/*
+ * Mann-Whitney U test of two samples, with the normal approximation and the
+ * correction for the ties.
+ */
+inline test_result mann_whitney(const std::vector<double>& a, const std::vector<double>& b){
+    auto n_a = a.size();
+    auto n_b = b.size();
+
+    if(!n_a || !n_b){
+        return {0.0, 0.0, 1.0};
+    }
+
+    std::vector<std::pair<double, bool>> values;
+    for(auto v : a){
+        values.emplace_back(v, true);
+    }
+    for(auto v : b){
+        values.emplace_back(v, false);
+    }
+
+    std::sort(values.begin(), values.end(), [](const std::pair<double, bool>& lhs, const std::pair<double, bool>& rhs){ return lhs.first < rhs.first; });
+
+    double rank_a = 0.0;
+    double ties = 0.0;
+
+    for(std::size_t i = 0; i < values.size();){
+        auto j = i;
+        while(j < values.size() && values[j].first == values[i].first){
+            ++j;
+        }
+
+        //The tied values share the average of their ranks
+        double rank = (i + 1 + j) / 2.0;
+        double t = j - i;
+
+        for(auto k = i; k < j; ++k){
+            if(values[k].second){
+                rank_a += rank;
+            }
+        }
+
+        ties += t * t * t - t;
+        i = j;
+    }
+
+    double n = n_a + n_b;
+    double u = rank_a - n_a * (n_a + 1.0) / 2.0;
+    double mean_u = n_a * n_b / 2.0;
+    double sigma_u = std::sqrt(n_a * n_b / 12.0 * ((n + 1.0) - ties / (n * (n - 1.0))));
+
+    if(sigma_u == 0.0){
+        return {u, 0.0, 1.0};
+    }
+
+    //Continuity correction
+    double z = (std::fabs(u - mean_u) - 0.5) / sigma_u;
+
+    return {u, 0.0, std::min(1.0, 2.0 * (1.0 - normal_cdf(std::max(z, 0.0))))};
+}
+
+/*
+ * Confidence interval of the ratio mean_b / mean_a, with the delta method on
+ * the logarithm of the ratio.
+ */
+inline std::pair<double, double> ratio_interval(double mean_a, double stderror_a, double mean_b, double stderror_b, double df, double confidence = 0.95){
+    double ratio = mean_b / mean_a;
+    double log_se = std::sqrt((stderror_a / mean_a) * (stderror_a / mean_a) + (stderror_b / mean_b) * (stderror_b / mean_b));
+
+    double q = df > 0.0 ? student_quantile(0.5 + confidence / 2.0, df) : 1.96;
+
+    return {ratio * std::exp(-q * log_se), ratio * std::exp(q * log_se)};
+}
+
+enum class correction {
+    NONE,
+    HOLM,              //Family-wise error rate
+    BENJAMINI_HOCHBERG //False discovery rate
+};
+
+//Adjust the p-values of a family of tests
+inline std::vector<double> adjust_p_values(const std::vector<double>& p, correction method){
+    auto m = p.size();
+
+    std::vector<double> adjusted(p);
+
+    if(method == correction::NONE || m < 2){
+        return adjusted;
+    }
+
+    std::vector<std::size_t> order(m);
+    std::iota(order.begin(), order.end(), 0);
+    std::sort(order.begin(), order.end(), [&p](std::size_t lhs, std::size_t rhs){ return p[lhs] < p[rhs]; });
+
+    if(method == correction::HOLM){
+        double running = 0.0;
+
+        for(std::size_t i = 0; i < m; ++i){
+            running = std::max(running, std::min(1.0, (m - i) * p[order[i]]));
+            adjusted[order[i]] = running;
+        }
+    } else {
+        double running = 1.0;
+
+        for(std::size_t i = m; i > 0; --i){
+            running = std::min(running, std::min(1.0, p[order[i - 1]] * m / i));
+            adjusted[order[i - 1]] = running;
+        }
+    }
+
+    return adjusted;
+}
+
+} //end of namespace cpm
+
+#endif //CPM_STATISTICS_HPP
@@ -0,0 +1,229 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_STORE_HPP
+#define CPM_STORE_HPP
+
+#include <map>
+#include <string>
+#include <vector>
+#include <fstream>
+#include <functional>
+#include <cerrno>
+#include <cstdlib>
+#include <algorithm>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+
+#include "binary.hpp"
+#include "json.hpp"
+#include "journal.hpp"
+
+namespace cpm {
+
+//Entry of the index of a results store
+struct store_entry {
+    std::uint64_t offset;
+    std::uint64_t size;
+    std::int64_t timestamp;
+    std::string name;
+    std::string compiler;
+    std::string configuration;
+    std::string tag;
+};
+
+/*
+ * Append-only results store of a folder. Each run is a binary record
+ * appended to results.store and results.index has one JSON line per record
+ * with its position and its keys. The appends are serialized by an
+ * exclusive lock on the index and a record is only visible once its index
+ * line is complete.
+ *
+ * The record is built under the lock, from the number of the run in the
+ * store, so that concurrent runs are numbered differently.
+ */
+struct results_store {
+    explicit results_store(std::string f) : folder(std::move(f)) {
+        if(!folder.empty() && folder.back() != '/'){
+            folder += '/';
+        }
+    }
+
+    std::string data_file() const {
+        return folder + "results.store";
+    }
+
+    std::string index_file() const {
+        return folder + "results.index";
+    }
+
+    bool exists() const {
+        return access(index_file().c_str(), F_OK) == 0;
+    }
+
+    bool append(const std::string& record, store_entry entry) const {
+        return append([&record](std::size_t, store_entry&){ return record; }, std::move(entry));
+    }
+
+    //Append the record built for the number of the run, the builder can complete the entry
+    bool append(const std::function<std::string(std::size_t, store_entry&)>& builder, store_entry entry) const {
+        int index_fd = ::open(index_file().c_str(), O_RDWR | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+
+        if(index_fd < 0){
+            return false;
+        }
+
+        //The lock is held until the index line is written
+        if(flock(index_fd, LOCK_EX) != 0){
+            ::close(index_fd);
+            return false;
+        }
+
+        bool appended = false;
+
+        //An interrupted append must not be merged with the next line
+        if(!drop_incomplete_line(index_fd)){
+            flock(index_fd, LOCK_UN);
+            ::close(index_fd);
+            return false;
+        }
+
+        auto record = builder(index().size() + 1, entry);
+
+        int data_fd = ::open(data_file().c_str(), O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+
+        struct stat buffer;
+        if(data_fd >= 0 && fstat(data_fd, &buffer) == 0){
+            //The records are aligned to be used in place once mapped
+            entry.offset = detail::binary_align(buffer.st_size);
+            entry.size = record.size();
+
+            appended =
+                   write_all(data_fd, record, entry.offset) && fdatasync(data_fd) == 0
+                && write_all(index_fd, index_line(entry), -1) && fsync(index_fd) == 0;
+        }
+
+        if(data_fd >= 0){
+            ::close(data_fd);
+        }
+
+        flock(index_fd, LOCK_UN);
+        ::close(index_fd);
+
+        return appended;
+    }
+
+    //The complete entries of the index, in order of append
+    std::vector<store_entry> index() const {
+        std::vector<store_entry> entries;
+
+        std::ifstream stream(index_file());
+
+        std::string line;
+        while(std::getline(stream, line)){
+            std::map<std::string, std::string> values;
+
+            //An interrupted append leaves an incomplete line
+            if(!detail::parse_journal_line(line, values)){
+                continue;
+            }
+
+            store_entry entry;
+            entry.offset        = std::strtoull(values["offset"].c_str(), nullptr, 10);
+            entry.size          = std::strtoull(values["size"].c_str(), nullptr, 10);
+            entry.timestamp     = std::strtoll(values["timestamp"].c_str(), nullptr, 10);
+            entry.name          = values["name"];
+            entry.compiler      = values["compiler"];
+            entry.configuration = values["configuration"];
+            entry.tag           = values["tag"];
+
+            entries.push_back(std::move(entry));
+        }
+
+        return entries;
+    }
+
+    //View the record of an entry in the mapped store
+    static bool record(const file_mapping& mapping, const store_entry& entry, binary_file& file){
+        return entry.offset + entry.size <= mapping.size && file.open(mapping.data + entry.offset, entry.size);
+    }
+
+private:
+    static std::string index_line(const store_entry& entry){
+        return "{\"offset\": " + std::to_string(entry.offset)
+            + ", \"size\": " + std::to_string(entry.size)
+            + ", \"timestamp\": " + std::to_string(entry.timestamp)
+            + ", \"name\": \"" + json_escape(entry.name)
+            + "\", \"compiler\": \"" + json_escape(entry.compiler)
+            + "\", \"configuration\": \"" + json_escape(entry.configuration)
+            + "\", \"tag\": \"" + json_escape(entry.tag) + "\"}\n";
+    }
+
+    //Truncate the index after its last complete line
+    static bool drop_incomplete_line(int fd){
+        struct stat buffer;
+        if(fstat(fd, &buffer) != 0){
+            return false;
+        }
+
+        std::int64_t end = buffer.st_size;
+        char block[4096];
+
+        while(end > 0){
+            auto begin = std::max<std::int64_t>(0, end - sizeof(block));
+            auto n = ::pread(fd, block, end - begin, begin);
+
+            if(n != end - begin){
+                return false;
+            }
+
+            for(auto i = n; i > 0; --i){
+                if(block[i - 1] == '\n'){
+                    auto last = begin + i;
+                    return last == buffer.st_size || ftruncate(fd, last) == 0;
+                }
+            }
+
+            end = begin;
+        }
+
+        //No complete line at all
+        return buffer.st_size == 0 || ftruncate(fd, 0) == 0;
+    }
+
+    //Write everything at the given offset, or at the end for a negative offset
+    static bool write_all(int fd, const std::string& data, std::int64_t offset){
+        std::size_t written = 0;
+
+        while(written < data.size()){
+            auto n = offset < 0
+                ? ::write(fd, data.data() + written, data.size() - written)
+                : ::pwrite(fd, data.data() + written, data.size() - written, offset + written);
+
+            if(n < 0){
+                if(errno == EINTR){
+                    continue;
+                }
+
+                return false;
+            }
+
+            written += n;
+        }
+
+        return true;
+    }
+
+    std::string folder;
+};
+
+} //end of namespace cpm
+
+#endif //CPM_STORE_HPP
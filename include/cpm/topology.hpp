@@ -0,0 +1,114 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_TOPOLOGY_HPP
+#define CPM_TOPOLOGY_HPP
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+
+namespace cpm {
+
+struct cache_level {
+    std::size_t level;
+    std::size_t size; //bytes
+    std::string name; //L1d, L2, L3, ...
+};
+
+namespace detail {
+
+inline bool read_sysfs_string(const std::string& path, std::string& value){
+    std::ifstream stream(path);
+    return static_cast<bool>(stream >> value);
+}
+
+//Parse the sysfs notation of cache sizes (32K, 8192K, 1M)
+inline std::size_t parse_cache_size(const std::string& value){
+    std::size_t size = 0;
+    std::size_t i = 0;
+
+    for(; i < value.size() && value[i] >= '0' && value[i] <= '9'; ++i){
+        size = size * 10 + (value[i] - '0');
+    }
+
+    if(i < value.size()){
+        if(value[i] == 'K'){
+            size *= 1024;
+        } else if(value[i] == 'M'){
+            size *= 1024 * 1024;
+        } else if(value[i] == 'G'){
+            size *= 1024 * 1024 * 1024;
+        }
+    }
+
+    return size;
+}
+
+inline std::vector<cache_level> read_data_caches(){
+    std::vector<cache_level> caches;
+
+    for(std::size_t index = 0;; ++index){
+        auto base = std::string("/sys/devices/system/cpu/cpu0/cache/index") + std::to_string(index) + "/";
+
+        std::string level;
+        std::string type;
+        std::string size;
+
+        if(!read_sysfs_string(base + "level", level) || !read_sysfs_string(base + "type", type) || !read_sysfs_string(base + "size", size)){
+            break;
+        }
+
+        if(type == "Instruction"){
+            continue;
+        }
+
+        cache_level cache;
+        cache.level = std::stoul(level);
+        cache.size = parse_cache_size(size);
+        cache.name = "L" + level + (type == "Data" ? "d" : "");
+
+        if(cache.size){
+            caches.push_back(cache);
+        }
+    }
+
+    std::sort(caches.begin(), caches.end(), [](const cache_level& lhs, const cache_level& rhs){ return lhs.level < rhs.level; });
+
+    //Assume a common hierarchy if the topology is not available
+    if(caches.empty()){
+        caches.push_back({1, 32 * 1024, "L1d"});
+        caches.push_back({2, 256 * 1024, "L2"});
+        caches.push_back({3, 8 * 1024 * 1024, "L3"});
+    }
+
+    return caches;
+}
+
+} //end of namespace detail
+
+//The data caches of the host, from the first level to the last one
+inline const std::vector<cache_level>& data_caches(){
+    static const std::vector<cache_level> caches = detail::read_data_caches();
+    return caches;
+}
+
+//The name of the level holding a working set of the given size in bytes
+inline std::string cache_regime(std::size_t bytes){
+    for(auto& cache : data_caches()){
+        if(bytes <= cache.size){
+            return cache.name;
+        }
+    }
+
+    return "DRAM";
+}
+
+} //end of namespace cpm
+
+#endif //CPM_TOPOLOGY_HPP
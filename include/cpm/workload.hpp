@@ -0,0 +1,409 @@
+//=======================================================================
+// Copyright (c) 2015-2016 Baptiste Wicht
+// Distributed under the terms of the MIT License.
+// (See accompanying file LICENSE or copy at
+//  http://opensource.org/licenses/MIT)
+//=======================================================================
+
+#ifndef CPM_WORKLOAD_HPP
+#define CPM_WORKLOAD_HPP
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include "duration.hpp"
+
+#ifdef CPM_PARALLEL_RANDOMIZE
+#include "parallel.hpp"
+#endif
+
+namespace cpm {
+
+//The distributions of the generated benchmark inputs
+enum class distribution : std::size_t {
+    UNIFORM,
+    SORTED,
+    REVERSE_SORTED,
+    NEARLY_SORTED,
+    ZIPF,
+    DUPLICATES,
+    CLUSTERED
+};
+
+inline const char* distribution_name(distribution d){
+    switch(d){
+        case distribution::UNIFORM:
+            return "uniform";
+        case distribution::SORTED:
+            return "sorted";
+        case distribution::REVERSE_SORTED:
+            return "reverse";
+        case distribution::NEARLY_SORTED:
+            return "nearly_sorted";
+        case distribution::ZIPF:
+            return "zipf";
+        case distribution::DUPLICATES:
+            return "duplicates";
+        case distribution::CLUSTERED:
+            return "clustered";
+    }
+
+    return "unknown";
+}
+
+//Parameters of the distributions, zero means a default derived from the size
+struct workload_options {
+    std::size_t keys = 0;     //Number of distinct keys (default: size)
+    double zipf_skew = 0.99;  //Exponent of the Zipfian distribution
+    std::size_t swaps = 0;    //Number of swaps of nearly sorted inputs (default: size / 100)
+    std::size_t distinct = 0; //Number of distinct values of duplicate-heavy inputs (default: size / 16)
+    std::size_t clusters = 16;
+    double spread = 0.01;     //Width of a cluster, relative to the key range
+};
+
+namespace detail {
+
+//Counter-based generator, each element is generated independently from its
+//index, which keeps the fill loops vectorizable and trivially parallel
+
+inline std::uint64_t splitmix64(std::uint64_t x){
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+inline double to_unit(std::uint64_t x){
+    return (x >> 11) * (1.0 / 9007199254740992.0);
+}
+
+inline std::uint64_t workload_seed(){
+#ifdef CPM_WORKLOAD_SEED
+    static std::mt19937_64 engine(CPM_WORKLOAD_SEED);
+#else
+    static std::random_device rd;
+    static std::mt19937_64 engine(rd());
+#endif
+    return engine();
+}
+
+template<typename Functor>
+void workload_for(std::size_t n, Functor&& functor){
+#ifdef CPM_PARALLEL_RANDOMIZE
+    parallel_for(n, std::forward<Functor>(functor));
+#else
+    functor(std::size_t(0), n);
+#endif
+}
+
+//Rejection-inversion sampling of a Zipfian distribution (Hoermann and Derflinger),
+//constant time per sample without any table
+struct zipf_sampler {
+    double n;
+    double s;
+    double h_integral_x1;
+    double h_integral_n;
+    double threshold;
+
+    zipf_sampler(std::size_t keys, double skew) : n(static_cast<double>(keys)), s(skew) {
+        h_integral_x1 = h_integral(1.5) - 1.0;
+        h_integral_n  = h_integral(n + 0.5);
+        threshold     = 2.0 - h_integral_inverse(h_integral(2.5) - h(2.0));
+    }
+
+    //Return a rank in [1, keys]
+    std::size_t operator()(std::uint64_t state) const {
+        while(true){
+            state = splitmix64(state);
+
+            const double u = h_integral_n + to_unit(state) * (h_integral_x1 - h_integral_n);
+            const double x = h_integral_inverse(u);
+
+            double k = std::floor(x + 0.5);
+            k = std::min(n, std::max(1.0, k));
+
+            if(k - x <= threshold || u >= h_integral(k + 0.5) - h(k)){
+                return static_cast<std::size_t>(k);
+            }
+        }
+    }
+
+private:
+    double h(double x) const {
+        return std::exp(-s * std::log(x));
+    }
+
+    double h_integral(double x) const {
+        const double log_x = std::log(x);
+        return helper2((1.0 - s) * log_x) * log_x;
+    }
+
+    double h_integral_inverse(double x) const {
+        double t = x * (1.0 - s);
+        if(t < -1.0){
+            t = -1.0;
+        }
+        return std::exp(helper1(t) * x);
+    }
+
+    static double helper1(double x){
+        return std::abs(x) > 1e-8 ? std::log1p(x) / x : 1.0 - x * (0.5 - x * (1.0 / 3.0 - 0.25 * x));
+    }
+
+    static double helper2(double x){
+        return std::abs(x) > 1e-8 ? std::expm1(x) / x : 1.0 + x * 0.5 * (1.0 + x * (1.0 / 3.0) * (1.0 + 0.25 * x));
+    }
+};
+
+template<typename T, std::enable_if_t<std::is_arithmetic<T>::value, int> = 42>
+T key_value(std::size_t key, std::size_t /*length*/){
+    return static_cast<T>(key);
+}
+
+//Keys are encoded in base 26 with a fixed length so that the lexicographic
+//order of the strings is the order of the keys
+template<typename T, std::enable_if_t<!std::is_arithmetic<T>::value, int> = 42>
+T key_value(std::size_t key, std::size_t length){
+    T value(length, 'a');
+
+    for(std::size_t i = length; i > 0 && key; --i){
+        value[i - 1] = static_cast<char>('a' + key % 26);
+        key /= 26;
+    }
+
+    return value;
+}
+
+template<typename T, std::enable_if_t<std::is_floating_point<T>::value, int> = 42>
+T uniform_value(std::uint64_t x, std::size_t /*keys*/, std::size_t /*length*/){
+    return static_cast<T>(-10000.0 + 20000.0 * to_unit(x));
+}
+
+template<typename T, std::enable_if_t<!std::is_floating_point<T>::value, int> = 42>
+T uniform_value(std::uint64_t x, std::size_t keys, std::size_t length){
+    return key_value<T>(x % keys, length);
+}
+
+template<typename C>
+using element_t = std::decay_t<decltype(std::declval<C&>()[0])>;
+
+} //end of namespace detail
+
+//Fill functions for the different distributions. The elements are keys in
+//[0, keys), except for uniform floating point values which are in the same
+//range as the randomization of cpm. Containers of std::string receive
+//keys of the given length.
+
+template<typename C>
+void fill_uniform(C& container, std::uint64_t seed = detail::workload_seed(), std::size_t keys = 0, std::size_t length = 0){
+    using T = detail::element_t<C>;
+    keys = keys ? keys : std::max(std::size_t(1), container.size());
+
+    detail::workload_for(container.size(), [&container, seed, keys, length](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            container[i] = detail::uniform_value<T>(detail::splitmix64(seed + i), keys, length);
+        }
+    });
+}
+
+template<typename C>
+void fill_sorted(C& container, std::size_t length = 0){
+    using T = detail::element_t<C>;
+
+    detail::workload_for(container.size(), [&container, length](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            container[i] = detail::key_value<T>(i, length);
+        }
+    });
+}
+
+template<typename C>
+void fill_reverse_sorted(C& container, std::size_t length = 0){
+    using T = detail::element_t<C>;
+    const std::size_t n = container.size();
+
+    detail::workload_for(n, [&container, n, length](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            container[i] = detail::key_value<T>(n - 1 - i, length);
+        }
+    });
+}
+
+template<typename C>
+void fill_nearly_sorted(C& container, std::size_t swaps, std::uint64_t seed = detail::workload_seed(), std::size_t length = 0){
+    using std::swap;
+
+    fill_sorted(container, length);
+
+    const std::size_t n = container.size();
+
+    if(n < 2){
+        return;
+    }
+
+    for(std::size_t k = 0; k < swaps; ++k){
+        auto a = detail::splitmix64(seed + 2 * k) % n;
+        auto b = detail::splitmix64(seed + 2 * k + 1) % n;
+        swap(container[a], container[b]);
+    }
+}
+
+template<typename C>
+void fill_zipf(C& container, std::size_t keys, double skew = 0.99, std::uint64_t seed = detail::workload_seed(), std::size_t length = 0){
+    using T = detail::element_t<C>;
+
+    const detail::zipf_sampler sampler(std::max(std::size_t(1), keys), skew);
+
+    //The most frequent key is 0
+    detail::workload_for(container.size(), [&container, &sampler, seed, length](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            container[i] = detail::key_value<T>(sampler(seed + i) - 1, length);
+        }
+    });
+}
+
+template<typename C>
+void fill_duplicates(C& container, std::size_t distinct, std::uint64_t seed = detail::workload_seed(), std::size_t length = 0){
+    using T = detail::element_t<C>;
+    distinct = std::max(std::size_t(1), distinct);
+
+    detail::workload_for(container.size(), [&container, distinct, seed, length](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            container[i] = detail::key_value<T>(detail::splitmix64(seed + i) % distinct, length);
+        }
+    });
+}
+
+template<typename C>
+void fill_clustered(C& container, std::size_t clusters, double spread, std::uint64_t seed = detail::workload_seed(), std::size_t keys = 0, std::size_t length = 0){
+    using T = detail::element_t<C>;
+    keys = keys ? keys : std::max(std::size_t(1), container.size());
+    clusters = std::max(std::size_t(1), clusters);
+
+    const double width = std::max(1.0, spread * keys);
+
+    detail::workload_for(container.size(), [&container, clusters, width, seed, keys, length](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            auto x = detail::splitmix64(seed + i);
+
+            //The center of a cluster only depends on the cluster index
+            const double center = detail::to_unit(detail::splitmix64(~seed + x % clusters)) * keys;
+            const double key = center + (detail::to_unit(detail::splitmix64(x)) - 0.5) * width;
+
+            container[i] = detail::key_value<T>(std::min(keys - 1, static_cast<std::size_t>(std::max(0.0, key))), length);
+        }
+    });
+}
+
+template<typename C>
+void fill_distribution(C& container, distribution dist, const workload_options& options = {}, std::uint64_t seed = detail::workload_seed(), std::size_t length = 0){
+    const std::size_t n = std::max(std::size_t(1), container.size());
+    const std::size_t keys = options.keys ? options.keys : n;
+
+    switch(dist){
+        case distribution::UNIFORM:
+            fill_uniform(container, seed, keys, length);
+            break;
+        case distribution::SORTED:
+            fill_sorted(container, length);
+            break;
+        case distribution::REVERSE_SORTED:
+            fill_reverse_sorted(container, length);
+            break;
+        case distribution::NEARLY_SORTED:
+            fill_nearly_sorted(container, options.swaps ? options.swaps : std::max(std::size_t(1), n / 100), seed, length);
+            break;
+        case distribution::ZIPF:
+            fill_zipf(container, keys, options.zipf_skew, seed, length);
+            break;
+        case distribution::DUPLICATES:
+            fill_duplicates(container, options.distinct ? options.distinct : std::max(std::size_t(1), n / 16), seed, length);
+            break;
+        case distribution::CLUSTERED:
+            fill_clustered(container, options.clusters, options.spread, seed, keys, length);
+            break;
+    }
+}
+
+//Generate n string keys of the given length following the given distribution
+template<typename C = std::vector<std::string>>
+C string_keys(std::size_t n, std::size_t length, distribution dist = distribution::UNIFORM, const workload_options& options = {}){
+    C keys(n);
+    fill_distribution(keys, dist, options, detail::workload_seed(), length);
+    return keys;
+}
+
+//A container filled following a distribution. It can be returned by the
+//init functor of a two-pass benchmark and is passed as a reference to the
+//base container to the functor. The randomization of cpm regenerates it
+//from the same distribution instead of filling it with uniform values.
+template<typename C>
+struct distributed : C {
+    distribution dist;
+    workload_options options;
+    std::size_t length;
+
+    distributed(std::size_t n, distribution dist, workload_options options = {}) : distributed(n, 0, dist, options) {}
+
+    distributed(std::size_t n, std::size_t length, distribution dist, workload_options options = {}) : C(n), dist(dist), options(options), length(length) {
+        fill();
+    }
+
+    void fill(){
+        fill_distribution(static_cast<C&>(*this), dist, options, detail::workload_seed(), length);
+    }
+};
+
+#ifndef CPM_NO_RANDOM_INITIALIZATION
+template<typename C>
+void random_init(distributed<C>& container){
+    container.fill();
+}
+#endif
+
+#ifndef CPM_NO_RANDOMIZATION
+template<typename C>
+void randomize(distributed<C>& container){
+    container.fill();
+}
+#endif
+
+//Policy to use the distribution as a dimension of a NARY_POLICY
+template<distribution... DD>
+struct distribution_policy {
+    static distribution begin(){
+        std::array<distribution, sizeof...(DD)> values{{DD...}};
+        return values[0];
+    }
+
+    static bool has_next(std::size_t i, distribution /*d*/, measure_result /*duration*/){
+        return (i + 1) < sizeof...(DD);
+    }
+
+    static distribution next(std::size_t i, distribution /*d*/){
+        std::array<distribution, sizeof...(DD)> values{{DD...}};
+        return values[i+1];
+    }
+};
+
+inline std::string dimension_to_string(distribution d){
+    return distribution_name(d);
+}
+
+//The distribution does not change the number of elements
+inline std::size_t dimension_to_eff(distribution /*d*/){
+    return 1;
+}
+
+inline std::string dimension_to_json(distribution d){
+    return std::string("\"") + distribution_name(d) + "\"";
+}
+
+} //end of namespace cpm
+
+#endif //CPM_WORKLOAD_HPP
@@ -10,7 +10,9 @@
 #include <vector>
 #include <algorithm>
 #include <set>
-#include <regex>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #include <stdio.h>
 #include <dirent.h>
@@ -19,16 +21,24 @@
 
 #include "cpm/io.hpp"
 #include "cpm/rapidjson.hpp"
+#include "rapidjson/prettywriter.h"
+#include "rapidjson/writer.h"
+#include "rapidjson/stringbuffer.h"
 #include "cpm/data.hpp"
 #include "cpm/raw_theme.hpp"
 #include "cpm/bootstrap_theme.hpp"
 #include "cpm/bootstrap_tabs_theme.hpp"
 #include "cpm/duration.hpp"
+#include "cpm/binary.hpp"
+#include "cpm/store.hpp"
+#include "cpm/parallel.hpp"
+#include "cpm/cache.hpp"
+#include "cpm/downsample.hpp"
+#include "cpm/changepoint.hpp"
+#include "cpm/statistics.hpp"
 
 namespace {
 
-using json_value = const rapidjson::Value&;
-
 bool str_equal(const char* lhs, const char* rhs){
     return std::strcmp(lhs, rhs) == 0;
 }
@@ -37,6 +47,10 @@ std::string dark_unica_theme =
 #include "dark_unica.inc.js"
 ;
 
+std::string charts_script =
+#include "cpm_charts.inc.js"
+;
+
 std::string strip_tags(const std::string& name){
     auto open = std::count(name.begin(), name.end(), '[');
     auto close = std::count(name.begin(), name.end(), ']');
@@ -56,23 +70,398 @@ std::string strip_tags(const std::string& name){
 }
 
 
-bool strip_equal(const std::string& lhs, const std::string& rhs){
-    return strip_tags(lhs) == strip_tags(rhs);
+//The mapped files and the allocators of the documents stay alive as long
+//as their documents are used. They are kept from the threads loading the
+//documents and released once the documents are destroyed.
+template<typename T>
+std::vector<std::unique_ptr<T>>& kept_alive(){
+    static std::vector<std::unique_ptr<T>> values;
+    return values;
+}
+
+template<typename T>
+void keep_alive(std::unique_ptr<T> value){
+    static std::mutex lock;
+
+    std::lock_guard<std::mutex> l(lock);
+    kept_alive<T>().push_back(std::move(value));
+}
+
+//Build the document of a binary result, the strings are not copied and
+//point directly in the mapped file
+cpm::document_t read_binary_document(const cpm::binary_file* file){
+    cpm::document_t doc;
+
+    auto& allocator = doc.GetAllocator();
+    auto& header = file->header();
+
+    auto string = [&file](std::uint32_t id){
+        return rapidjson::StringRef(file->string(id), file->length(id));
+    };
+
+    auto point = [&](std::size_t i){
+        rapidjson::Value value(rapidjson::kObjectType);
+
+        value.AddMember("size", string(file->sizes()[i]), allocator);
+        value.AddMember("size_eff", file->size_eff()[i], allocator);
+
+        if(file->regimes()[i] != cpm::binary_none){
+            value.AddMember("regime", string(file->regimes()[i]), allocator);
+        }
+
+        if(file->coordinates()[i] != cpm::binary_none){
+            cpm::document_t coordinates;
+            coordinates.Parse(file->string(file->coordinates()[i]));
+
+            rapidjson::Value copy(coordinates, allocator);
+            value.AddMember("coordinates", copy, allocator);
+        }
+
+        value.AddMember("mean", file->metric(cpm::BINARY_MEAN)[i], allocator);
+        value.AddMember("mean_lb", file->metric(cpm::BINARY_MEAN_LB)[i], allocator);
+        value.AddMember("mean_ub", file->metric(cpm::BINARY_MEAN_UB)[i], allocator);
+        value.AddMember("stddev", file->metric(cpm::BINARY_STDDEV)[i], allocator);
+        value.AddMember("min", file->metric(cpm::BINARY_MIN)[i], allocator);
+        value.AddMember("max", file->metric(cpm::BINARY_MAX)[i], allocator);
+        value.AddMember("flops", file->flops()[i], allocator);
+
+        if(file->metric(cpm::BINARY_NOISE)[i] >= 0.0){
+            value.AddMember("noise", file->metric(cpm::BINARY_NOISE)[i], allocator);
+        }
+
+        value.AddMember("throughput", file->metric(cpm::BINARY_THROUGHPUT_E)[i], allocator);
+        value.AddMember("throughput_e", file->metric(cpm::BINARY_THROUGHPUT_E)[i], allocator);
+        value.AddMember("throughput_f", file->metric(cpm::BINARY_THROUGHPUT_F)[i], allocator);
+
+        return value;
+    };
+
+    doc.SetObject();
+
+    doc.AddMember("name", string(header.name), allocator);
+    doc.AddMember("tag", string(header.tag), allocator);
+    doc.AddMember("configuration", string(header.configuration), allocator);
+    doc.AddMember("compiler", string(header.compiler), allocator);
+    doc.AddMember("os", string(header.os), allocator);
+
+    if(header.environment != cpm::binary_none){
+        cpm::document_t environment;
+        environment.Parse(file->string(header.environment));
+
+        if(!environment.HasParseError()){
+            rapidjson::Value copy(environment, allocator);
+            doc.AddMember("environment", copy, allocator);
+        }
+    }
+
+    if(header.shard != cpm::binary_none){
+        doc.AddMember("shard", string(header.shard), allocator);
+    }
+
+    if(header.seed){
+        doc.AddMember("seed", header.seed, allocator);
+    }
+
+    doc.AddMember("time", string(header.time), allocator);
+    doc.AddMember("timestamp", header.timestamp, allocator);
+
+    rapidjson::Value results(rapidjson::kArrayType);
+    rapidjson::Value sections(rapidjson::kArrayType);
+
+    for(std::size_t i = 0; i < header.n_series; ++i){
+        auto& series = file->series()[i];
+
+        rapidjson::Value points(rapidjson::kArrayType);
+        points.Reserve(series.count, allocator);
+
+        for(std::size_t j = series.first; j < series.first + series.count; ++j){
+            auto value = point(j);
+            points.PushBack(value, allocator);
+        }
+
+        if(series.section == cpm::binary_none){
+            rapidjson::Value result(rapidjson::kObjectType);
+            result.AddMember("title", string(series.title), allocator);
+            result.AddMember("duration", series.duration, allocator);
+            result.AddMember("results", points, allocator);
+            results.PushBack(result, allocator);
+        } else {
+            //The implementations of a section are consecutive
+            if(!i || file->series()[i - 1].section != series.section){
+                rapidjson::Value section(rapidjson::kObjectType);
+                rapidjson::Value implementations(rapidjson::kArrayType);
+                section.AddMember("name", string(series.section), allocator);
+                section.AddMember("duration", series.duration, allocator);
+                section.AddMember("results", implementations, allocator);
+                sections.PushBack(section, allocator);
+            }
+
+            rapidjson::Value implementation(rapidjson::kObjectType);
+            implementation.AddMember("name", string(series.title), allocator);
+            implementation.AddMember("results", points, allocator);
+            sections[sections.Size() - 1]["results"].PushBack(implementation, allocator);
+        }
+    }
+
+    doc.AddMember("results", results, allocator);
+    doc.AddMember("sections", sections, allocator);
+
+    return doc;
+}
+
+cpm::document_t read_binary_document(const std::string& path){
+    std::unique_ptr<cpm::file_mapping> mapping(new cpm::file_mapping);
+    cpm::binary_file file;
+
+    if(!mapping->open(path) || !file.open(mapping->data, mapping->size)){
+        //Empty document error
+        cpm::document_t doc;
+        doc.Parse("");
+        return doc;
+    }
+
+    keep_alive(std::move(mapping));
+
+    return read_binary_document(&file);
+}
+
+//Map the binary result file, nullptr if it is not valid
+std::unique_ptr<cpm::binary_file> open_binary(const std::string& path){
+    std::unique_ptr<cpm::binary_file> file(new cpm::binary_file);
+
+    if(!file->open(path)){
+        return nullptr;
+    }
+
+    return file;
+}
+
+//Map the results store of the folder and view the records accepted by the filter
+template<typename Filter>
+std::vector<std::unique_ptr<cpm::binary_file>> view_store(const std::string& folder, Filter filter){
+    std::vector<std::unique_ptr<cpm::binary_file>> files;
+
+    cpm::results_store store(folder);
+
+    //The index is read first, the records appended later are not mapped
+    auto index = store.index();
+
+    std::unique_ptr<cpm::file_mapping> mapping(new cpm::file_mapping);
+
+    if(index.empty() || !mapping->open(store.data_file())){
+        return files;
+    }
+
+    for(auto& entry : index){
+        if(!filter(entry)){
+            continue;
+        }
+
+        std::unique_ptr<cpm::binary_file> file(new cpm::binary_file);
+        if(cpm::results_store::record(*mapping, entry, *file)){
+            files.push_back(std::move(file));
+        } else {
+            std::cout << "Impossible to read the record " << entry.tag << " (" << entry.offset << ") of " << store.data_file() << std::endl;
+        }
+    }
+
+    keep_alive(std::move(mapping));
+
+    return files;
+}
+
+//Map the results store of the folder and read the entries accepted by the filter
+template<typename Filter>
+std::vector<cpm::document_t> read_store(const std::string& folder, Filter filter){
+    std::vector<cpm::document_t> documents;
+
+    for(auto& file : view_store(folder, filter)){
+        documents.push_back(read_binary_document(file.get()));
+    }
+
+    return documents;
 }
 
-cpm::document_t read_document(const std::string& folder, const std::string& file){
-    FILE* pFile = fopen((folder + "/" + file).c_str(), "rb");
+cpm::document_t read_document(const std::string& path){
+    if(cpm::binary_file::is_binary(path)){
+        return read_binary_document(path);
+    }
+
+    cpm::document_t doc;
+
+    FILE* pFile = fopen(path.c_str(), "rb");
+
+    if(!pFile){
+        //Empty document error
+        doc.Parse("");
+        return doc;
+    }
+
     char buffer[65536];
 
     rapidjson::FileReadStream is(pFile, buffer, sizeof(buffer));
-    cpm::document_t doc;
     doc.ParseStream<0>(is);
 
+    fclose(pFile);
+
     return doc;
 }
 
-std::vector<cpm::document_t> read(const std::string& source_folder, cxxopts::Options& options){
-    std::vector<cpm::document_t> documents;
+//Parse a JSON result file in situ. The file is mapped privately (copy on
+//write) and the strings of the document point in the mapping. The nodes
+//are allocated in a pool sized after the file.
+cpm::document_t read_json_document(const std::string& path){
+    static const std::size_t page_size = sysconf(_SC_PAGESIZE);
+
+    std::unique_ptr<cpm::file_mapping> mapping(new cpm::file_mapping);
+
+    //The parser needs the '\0' following the file in its last page
+    if(!mapping->open(path, true) || mapping->size % page_size == 0){
+        return read_document(path);
+    }
+
+    using allocator_t = cpm::document_t::AllocatorType;
+
+    std::unique_ptr<allocator_t> allocator(new allocator_t(std::max(mapping->size, std::size_t(64 * 1024))));
+
+    cpm::document_t doc(allocator.get());
+    doc.ParseInsitu(mapping->data);
+
+    keep_alive(std::move(mapping));
+    keep_alive(std::move(allocator));
+
+    return doc;
+}
+
+std::string json_string(const rapidjson::Value& value){
+    if(value.IsString()){
+        return value.GetString();
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+    value.Accept(writer);
+
+    return buffer.GetString();
+}
+
+double json_number(const rapidjson::Value& value, const char* key){
+    return value.HasMember(key) ? value[key].GetDouble() : 0.0;
+}
+
+std::int64_t json_duration(const rapidjson::Value& value){
+    return value.HasMember("duration") ? value["duration"].GetInt64() : 0;
+}
+
+bool write_binary_document(const cpm::document_t& doc, const std::string& path){
+    cpm::binary_writer writer;
+
+    writer.run(doc["name"].GetString(), doc["tag"].GetString(), doc["configuration"].GetString(), doc["compiler"].GetString(),
+        doc["os"].GetString(), doc["time"].GetString(), doc["timestamp"].GetInt64(), doc.HasMember("shard") ? doc["shard"].GetString() : "");
+
+    if(doc.HasMember("environment")){
+        writer.environment(json_string(doc["environment"]));
+    }
+
+    if(doc.HasMember("seed")){
+        writer.seed(doc["seed"].GetUint());
+    }
+
+    auto points = [&writer](const rapidjson::Value& values){
+        for(auto& r : values){
+            cpm::measure_result result;
+            result.mean         = json_number(r, "mean");
+            result.mean_lb      = json_number(r, "mean_lb");
+            result.mean_ub      = json_number(r, "mean_ub");
+            result.stddev       = json_number(r, "stddev");
+            result.min          = json_number(r, "min");
+            result.max          = json_number(r, "max");
+            result.throughput_e = r.HasMember("throughput_e") ? json_number(r, "throughput_e") : json_number(r, "throughput");
+            result.throughput_f = json_number(r, "throughput_f");
+            result.flops        = r.HasMember("flops") ? r["flops"].GetUint64() : 0;
+            result.noise        = r.HasMember("noise") ? json_number(r, "noise") : -1.0;
+
+            writer.point(json_string(r["size"]), r.HasMember("size_eff") ? r["size_eff"].GetUint64() : 0,
+                r.HasMember("regime") ? r["regime"].GetString() : "", r.HasMember("coordinates") ? json_string(r["coordinates"]) : "", result);
+        }
+    };
+
+    for(auto& r : doc["results"]){
+        writer.start_series("", r["title"].GetString(), json_duration(r));
+        points(r["results"]);
+    }
+
+    if(doc.HasMember("sections")){
+        for(auto& section : doc["sections"]){
+            for(auto& implementation : section["results"]){
+                writer.start_series(section["name"].GetString(), implementation["name"].GetString(), json_duration(section));
+                points(implementation["results"]);
+            }
+        }
+    }
+
+    return writer.write(path);
+}
+
+bool ends_with(const std::string& value, const std::string& suffix){
+    return value.size() >= suffix.size() && value.compare(value.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+bool is_result_file(const std::string& file){
+    return ends_with(file, ".cpm") || ends_with(file, ".cpmb");
+}
+
+//Add the groups of results of the document to the changes
+void document_groups(const cpm::document_t& doc, cpm::report_changes& changes){
+    for(auto& r : doc["results"]){
+        changes.add(doc["compiler"].GetString(), doc["configuration"].GetString(), strip_tags(r["title"].GetString()));
+    }
+
+    if(doc.HasMember("sections")){
+        for(auto& section : doc["sections"]){
+            changes.add(doc["compiler"].GetString(), doc["configuration"].GetString(), strip_tags(section["name"].GetString()));
+        }
+    }
+}
+
+//Add the groups of results of the binary result to the changes
+void document_groups(const cpm::binary_file& file, cpm::report_changes& changes){
+    auto& header = file.header();
+
+    for(std::size_t i = 0; i < header.n_series; ++i){
+        auto& series = file.series()[i];
+        auto name = series.section == cpm::binary_none ? series.title : series.section;
+
+        changes.add(file.string(header.compiler), file.string(header.configuration), strip_tags(file.string(name)));
+    }
+}
+
+//A run of the report, a binary result used in place or the document of a JSON result
+struct report_source {
+    std::unique_ptr<cpm::binary_file> file; //nullptr for a document
+    cpm::document_t doc;
+
+    bool valid() const {
+        return file || !doc.HasParseError();
+    }
+
+    std::string tag() const {
+        return file ? file->string(file->header().tag) : doc["tag"].GetString();
+    }
+
+    std::int64_t timestamp() const {
+        return file ? file->header().timestamp : doc["timestamp"].GetInt64();
+    }
+};
+
+//Read the runs of the folder, the unchanged files are read from the
+//cache and the groups of the new, changed and removed documents are
+//collected in the changes. The binary results and the cache are used in
+//place, only the new JSON results are parsed.
+std::vector<report_source> read(const std::string& source_folder, cxxopts::Options& options, cpm::report_cache& cache, cpm::report_changes& changes){
+    std::vector<report_source> documents;
+
+    std::vector<std::string> files;
 
     struct dirent* entry;
     DIR* dp = opendir(source_folder.c_str());
@@ -82,57 +471,178 @@ std::vector<cpm::document_t> read(const std::string& source_folder, cxxopts::Opt
     }
 
     while((entry = readdir(dp))){
-        if(str_equal(entry->d_name, ".") || str_equal(entry->d_name, "..")){
-            continue;
+        //Only the result files (not the journals of the running benchmarks)
+        if(entry->d_type == DT_REG && is_result_file(entry->d_name)){
+            files.push_back(entry->d_name);
         }
+    }
 
-        if(entry->d_type == DT_REG){
-            intel_decltype_auto doc = read_document(source_folder, entry->d_name);
-            if(doc.HasParseError()){
-                std::cout
-                    << "Impossible to read document " << entry->d_name << ":" << doc.GetErrorOffset()
-                    << ", parse error: " << rapidjson::GetParseError_En(doc.GetParseError()) << std::endl;
+    closedir(dp);
+
+    //The order of the directory is not deterministic
+    std::sort(files.begin(), files.end());
+
+    std::vector<cpm::cache_source> stamps(files.size());
+    std::vector<std::string> cached(files.size());
+    std::vector<char> known(files.size()); //Unchanged since the last generation
+
+    for(std::size_t i = 0; i < files.size(); ++i){
+        struct stat buffer;
+        if(stat((source_folder + "/" + files[i]).c_str(), &buffer) == 0){
+            stamps[i].size = buffer.st_size;
+            stamps[i].mtime = std::int64_t(buffer.st_mtim.tv_sec) * 1000000000 + buffer.st_mtim.tv_nsec;
+        }
+
+        auto previous = cache.previous(files[i]);
+
+        if(previous && cache.unchanged(files[i], stamps[i].size, stamps[i].mtime)){
+            stamps[i] = *previous;
+            cached[i] = previous->cache.empty() ? std::string() : cache.path(previous->cache);
+            known[i] = true;
+        } else if(previous){
+            //The results it contained before have changed too
+            changes.add(previous->compiler, previous->configuration);
+        }
+    }
+
+    std::vector<report_source> loaded(files.size());
+    std::vector<char> fresh(files.size()); //Not std::vector<bool>, the threads write distinct elements
+
+    cpm::parallel_for(files.size(), [&](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            auto path = source_folder + "/" + files[i];
+
+            if(!cached[i].empty()){
+                loaded[i].file = open_binary(cached[i]);
+
+                if(loaded[i].file){
+                    continue;
+                }
+
+                //The cached document is replaced
+                stamps[i].cache.clear();
+            }
+
+            if(ends_with(files[i], ".cpmb")){
+                loaded[i].file = open_binary(path);
+
+                if(!loaded[i].file){
+                    //Empty document error
+                    loaded[i].doc.Parse("");
+                }
             } else {
-                documents.push_back(std::move(doc));
+                loaded[i].doc = read_json_document(path);
+            }
+
+            if(loaded[i].valid() && stamps[i].cache.empty()){
+                fresh[i] = true;
+
+                //The binary results are already used in place
+                if(!loaded[i].file && cache.enabled && write_binary_document(loaded[i].doc, cache.path(cache.cache_file(files[i])))){
+                    stamps[i].cache = cache.cache_file(files[i]);
+                }
+            }
+        }
+    }, 1);
+
+    for(std::size_t i = 0; i < files.size(); ++i){
+        if(!loaded[i].valid()){
+            std::cout
+                << "Impossible to read document " << files[i] << ":" << loaded[i].doc.GetErrorOffset()
+                << ", parse error: " << rapidjson::GetParseError_En(loaded[i].doc.GetParseError()) << std::endl;
+        } else {
+            if(fresh[i]){
+                auto& file = loaded[i].file;
+
+                //An unchanged source whose document could not be cached is parsed again, but its results did not change
+                if(!known[i]){
+                    if(file){
+                        document_groups(*file, changes);
+                    } else {
+                        document_groups(loaded[i].doc, changes);
+                    }
+                }
+
+                stamps[i].compiler = file ? file->string(file->header().compiler) : loaded[i].doc["compiler"].GetString();
+                stamps[i].configuration = file ? file->string(file->header().configuration) : loaded[i].doc["configuration"].GetString();
+
+                cache.update(files[i], stamps[i]);
+            }
+
+            documents.push_back(std::move(loaded[i]));
+        }
+    }
+
+    cpm::results_store store(source_folder);
+
+    if(store.exists()){
+        //The records are never modified, only the new ones are changes
+        for(auto& entry : store.index()){
+            auto source = "results.store@" + std::to_string(entry.offset);
+
+            if(!cache.unchanged(source, entry.size, entry.timestamp)){
+                changes.add(entry.compiler, entry.configuration);
+                cache.update(source, {std::int64_t(entry.size), entry.timestamp, "", entry.compiler, entry.configuration});
             }
         }
+
+        for(auto& file : view_store(source_folder, [](const cpm::store_entry&){ return true; })){
+            documents.emplace_back();
+            documents.back().file = std::move(file);
+        }
     }
 
+    cache.remove_unseen(changes);
+
     if(options.count("sort-by-tag")){
-        std::sort(documents.begin(), documents.end(),
-            [](cpm::document_t& lhs, cpm::document_t& rhs){
-                if(std::string(lhs["tag"].GetString()) < std::string(rhs["tag"].GetString())){
+        std::stable_sort(documents.begin(), documents.end(),
+            [](const report_source& lhs, const report_source& rhs){
+                if(lhs.tag() < rhs.tag()){
                     return true;
-                } else if(std::string(lhs["tag"].GetString()) > std::string(rhs["tag"].GetString())){
+                } else if(lhs.tag() > rhs.tag()){
                     return false;
                 } else {
                     //If same tag, sort by time
-                    return lhs["timestamp"].GetInt() < rhs["timestamp"].GetInt();
+                    return lhs.timestamp() < rhs.timestamp();
                 }
             }
         );
     } else {
-        std::sort(documents.begin(), documents.end(),
-            [](cpm::document_t& lhs, cpm::document_t& rhs){ return lhs["timestamp"].GetInt() < rhs["timestamp"].GetInt(); });
+        std::stable_sort(documents.begin(), documents.end(),
+            [](const report_source& lhs, const report_source& rhs){ return lhs.timestamp() < rhs.timestamp(); });
     }
 
     return documents;
 }
 
-//Select relevant documents
-std::vector<cpm::document_cref> select_documents(const std::vector<cpm::document_t>& documents, const cpm::document_t& base){
-    std::vector<cpm::document_cref> relevant;
+//Select the runs relevant for the base run
+std::vector<std::size_t> select_runs(const cpm::reports_data& data, const cpm::report_run& base){
+    std::vector<std::size_t> relevant;
 
-    for(auto& doc : documents){
-        //Two documents are relevant if the configuration is the same
-        if(str_equal(doc["compiler"].GetString(), base["compiler"].GetString()) && str_equal(doc["configuration"].GetString(), base["configuration"].GetString())){
-            relevant.push_back(std::cref(doc));
+    for(std::size_t i = 0; i < data.runs.size(); ++i){
+        //Two runs are relevant if the configuration is the same
+        if(data.runs[i].compiler == base.compiler && data.runs[i].configuration == base.configuration){
+            relevant.push_back(i);
         }
     }
 
     return relevant;
 }
 
+//String literal for the scripts of the pages and the data files
+std::string js_string(const std::string& value){
+    std::string literal = "\"" + cpm::json_escape(value) + "\"";
+
+    //The literal must not close the script element
+    std::size_t i = 0;
+    while((i = literal.find("</", i)) != std::string::npos){
+        literal.insert(i + 1, "\\");
+        i += 3;
+    }
+
+    return literal;
+}
+
 template<typename Theme>
 void header(Theme& theme){
     theme << "<!DOCTYPE html>\n";
@@ -144,7 +654,7 @@ void header(Theme& theme){
     theme << "<meta name=\"viewport\" content=\"width=device-width, initial-scale=1\">\n";
     theme << "<meta http-equiv=\"X-UA-Compatible\" content=\"IE=edge\">\n";
 
-    theme << "<title>" << theme.data.documents.back()["name"].GetString() << "</title>\n";
+    theme << "<title>" << theme.data.str(theme.data.runs.back().name) << "</title>\n";
 
     //We need JQuery
     theme << "<script src=\"https://code.jquery.com/jquery-1.11.3.min.js\"></script>\n";
@@ -154,6 +664,13 @@ void header(Theme& theme){
     theme << "<script src=\"https://code.highcharts.com/highcharts.js\"></script>\n";
     theme << "<script src=\"https://code.highcharts.com/modules/exporting.js\"></script>\n";
 
+    //The charts are drawn from the data files shared by all the pages
+    theme << "<script src=\"data/cpm.js\"></script>\n";
+    theme << "<script src=\"data/runs.js\"></script>\n";
+    theme << "<script>cpm.configure({ mflops: " << (theme.options.count("mflops-graphs") ? "true" : "false")
+        << ", time_sizes: " << (theme.options.count("time-sizes") ? "true" : "false")
+        << ", compiler: " << js_string(theme.current_compiler) << ", configuration: " << js_string(theme.current_configuration) << " });</script>\n";
+
     theme.include();
 
     theme << "</head>\n";
@@ -172,14 +689,16 @@ void footer(Theme& theme){
 }
 
 template<typename Theme>
-void information(Theme& theme, const cpm::document_t& doc){
-    theme.before_information(doc["name"].GetString());
+void information(Theme& theme, const cpm::report_run& run){
+    auto& data = theme.data;
 
-    theme << "<li>Tag: " << doc["tag"].GetString() << "</li>\n";
-    theme << "<li>Compiler: " << doc["compiler"].GetString() << "</li>\n";
-    theme << "<li>Configuration: " << doc["configuration"].GetString() << "</li>\n";
-    theme << "<li>Operating System: " << doc["os"].GetString() << "</li>\n";
-    theme << "<li>Time: " << doc["time"].GetString() << "</li>\n";
+    theme.before_information(data.str(run.name));
+
+    theme << "<li>Tag: " << data.str(run.tag) << "</li>\n";
+    theme << "<li>Compiler: " << data.str(run.compiler) << "</li>\n";
+    theme << "<li>Configuration: " << data.str(run.configuration) << "</li>\n";
+    theme << "<li>Operating System: " << data.str(run.os) << "</li>\n";
+    theme << "<li>Time: " << data.str(run.time) << "</li>\n";
 
     theme.after_information();
 }
@@ -203,231 +722,143 @@ void after_buttons(Theme& theme){
     theme.after_buttons();
 }
 
-template<typename Theme>
-void start_graph(Theme& theme, const std::string& id, const std::string& title){
-    theme << "<script>\n";
-
-    theme << "$(function () {\n";
-    theme << "$('#" << id << "').highcharts({\n";
-    theme << "title: { text: '" << std::regex_replace(title, std::regex("'"), "\\'") << "', x: -20 },\n";
-}
-
-template<typename Theme>
-void end_graph(Theme& theme){
-    theme << "});\n";
-    theme << "});\n";
-
-    theme << "</script>\n";
-}
-
-template<typename Theme>
-void y_axis_configuration(Theme& theme){
-    theme << "yAxis: {\n";
+//Stable identifier of a run, shared by the pages and the data files
+std::string run_id(const cpm::reports_data& data, const cpm::report_run& run){
+    auto hash = cpm::fnv1a(std::to_string(run.timestamp));
 
-    if(theme.options.count("mflops-graphs")){
-        theme << "title: { text: 'Throughput [MFlops/s]' },\n";
-    } else {
-        theme << "title: { text: 'Time [ns]' },\n";
+    for(auto id : {run.name, run.tag, run.compiler, run.configuration, run.os, run.time}){
+        hash = cpm::fnv1a(data.str(id) + '\0', hash);
     }
 
-    theme << "plotLines: [{ value: 0, width: 1, color: '#808080'}]\n";
-    theme << "},\n";
-
-    if(theme.options.count("mflops-graphs")){
-        theme << "tooltip: { valueSuffix: 'MFlops/s' },\n";
-    } else {
-        theme << "tooltip: { valueSuffix: 'ns' },\n";
-    }
+    char buffer[16];
+    snprintf(buffer, sizeof(buffer), "%012llx", static_cast<unsigned long long>(hash & 0xFFFFFFFFFFFFULL));
+    return buffer;
 }
 
-template<typename Theme, typename Elements>
-void json_array_string(Theme& theme, const Elements& elements){
-    theme << "[";
-
-    std::string comma = "";
-    for(auto& element : elements){
-        theme << comma << "'" << element << "'";
-        comma = ",";
-    }
+//The data file of the results of a bench (or of a section) in all the runs
+std::string data_file(bool section, const std::string& name){
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "data/%016llx.js", static_cast<unsigned long long>(cpm::fnv1a((section ? "section\1" : "bench\1") + name)));
+    return buffer;
+}
 
-    theme << "]";
+//Anchor of the results of a bench (or of a section) in a page
+std::string result_anchor(bool section, const std::string& name){
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "result_%016llx", static_cast<unsigned long long>(cpm::fnv1a((section ? "section\1" : "bench\1") + name)));
+    return buffer;
 }
 
-template<typename Theme, typename Elements>
-void json_array_value(Theme& theme, const Elements& elements){
-    theme << "[";
+//Chart drawn by data/cpm.js from the data file of its bench once it is visible
+template<typename Theme>
+void lazy_chart(Theme& theme, const std::string& id, const char* graph, const cpm::report_run& base, bool section, const std::string& name, const std::string& title, const std::string& impl = ""){
+    theme << "<script>cpm.chart(" << js_string(id) << ", { file: '" << data_file(section, name) << "', graph: '" << graph
+        << "', run: '" << run_id(theme.data, base) << "', section: " << (section ? "true" : "false") << ", title: " << js_string(title);
 
-    std::string comma = "";
-    for(auto& element : elements){
-        theme << comma << element;
-        comma = ",";
+    if(!impl.empty()){
+        theme << ", impl: " << js_string(impl);
     }
 
-    theme << "]";
+    theme << " });</script>\n";
 }
 
-template<typename T>
-std::vector<std::string> string_collect(const T& parent, const char* attr){
+std::vector<std::string> title_collect(const cpm::reports_data& data, cpm::report_range<cpm::report_series> series){
     std::vector<std::string> values;
-    for(auto& r : parent){
-        values.emplace_back(strip_tags(r[attr].GetString()));
-    }
-    return values;
-}
-
-template<typename T>
-std::vector<int> int_collect(const T& parent, const char* attr){
-    std::vector<int> values;
-    for(auto& r : parent){
-        values.emplace_back(r[attr].GetInt());
-    }
-    return values;
-}
-
-template<typename T>
-std::vector<double> double_collect(const T& parent, const char* attr){
-    std::vector<double> values;
-    for(auto& r : parent){
-        values.emplace_back(r[attr].GetDouble());
+    for(auto& s : series){
+        values.push_back(data.str(s.title));
     }
     return values;
 }
 
 template<typename Theme>
-const char* value_key_name(Theme& theme){
+cpm::report_metric value_metric(Theme& theme){
     if(theme.options.count("mflops-graphs")){
-        return "throughput_f";
+        return cpm::METRIC_THROUGHPUT_F;
     } else {
-        return "mean";
+        return cpm::METRIC_MEAN;
     }
 }
 
 template<typename Theme>
-void generate_run_graph(Theme& theme, std::size_t& id, const rapidjson::Value& result){
-    theme.before_graph(id);
-
-    std::string title = std::string("Last run") +
-        (theme.options.count("pages") ? std::string() : std::string(": ") + strip_tags(result["title"].GetString()));
-
-    start_graph(theme, std::string("chart_") + std::to_string(id), title);
+void generate_run_graph(Theme& theme, std::size_t& id, const cpm::report_series& result, const cpm::report_run& base){
+    auto& name = theme.data.str(result.title);
 
-    theme << "xAxis: { categories: \n";
-
-    json_array_string(theme, string_collect(result["results"], "size"));
-
-    theme << "},\n";
-
-    y_axis_configuration(theme);
+    theme.before_graph(id);
 
-    theme << "legend: { enabled: false },\n";
+    lazy_chart(theme, std::string("chart_") + std::to_string(id), "run", base, false, name,
+        std::string("Last run") + (theme.options.count("pages") ? std::string() : std::string(": ") + name));
 
-    theme << "series: [\n";
-    theme << "{\n";
+    theme.after_graph();
+    ++id;
+}
 
-    theme << "name: '',\n";
-    theme << "data: ";
+template<typename Theme>
+void generate_compare_graph(Theme& theme, std::size_t& id, const cpm::report_series& base_result, const std::string& title, const char* graph, const cpm::report_run& base){
+    auto& name = theme.data.str(base_result.title);
 
-    json_array_value(theme, double_collect(result["results"], value_key_name(theme)));
+    theme.before_graph(id);
 
-    theme << "\n}\n";
-    theme << "]\n";
+    lazy_chart(theme, std::string("chart_") + std::to_string(id), graph, base, false, name,
+        title + (theme.options.count("pages") ? std::string() : std::string(": ") + name));
 
-    end_graph(theme);
     theme.after_graph();
     ++id;
 }
 
-template<typename Theme, typename Filter>
-void generate_compare_graph(Theme& theme, std::size_t& id, json_value base_result, const std::string& title, const char* attr, Filter f){
-    theme.before_graph(id);
+bool is_compiler_relevant(const cpm::report_run& base, const cpm::report_run& run){
+    return run.tag == base.tag && run.configuration == base.configuration;
+}
 
-    std::string graph_title = title +
-        (theme.options.count("pages") ? std::string() : std::string(": ") + strip_tags(base_result["title"].GetString()));
-    start_graph(theme, std::string("chart_") + std::to_string(id), graph_title);
+bool is_configuration_relevant(const cpm::report_run& base, const cpm::report_run& run){
+    return run.tag == base.tag && run.compiler == base.compiler;
+}
 
-    theme << "xAxis: { categories: \n";
-
-    json_array_string(theme, string_collect(base_result["results"], "size"));
-
-    theme << "},\n";
-
-    y_axis_configuration(theme);
-
-    theme << "legend: { align: 'left', verticalAlign: 'top', floating: false, borderWidth: 0, y: 20 },\n";
-
-    theme << "series: [\n";
-
-    std::string comma = "";
-    for(auto& document : theme.data.documents){
-        if(f(document)){
-            for(auto& result : document["results"]){
-                if(strip_equal(result["title"].GetString(), base_result["title"].GetString())){
-                    theme << comma << "{\n";
-                    theme << "name: '" << document[attr].GetString() << "',\n";
-                    theme << "data: ";
-
-                    json_array_value(theme, double_collect(result["results"], value_key_name(theme)));
-
-                    theme << "\n}\n";
-
-                    comma = ",";
-                }
-            }
-        }
-    }
-
-    theme << "]\n";
-
-    end_graph(theme);
-    theme.after_graph();
-    ++id;
-}
-
-bool is_compiler_relevant(const cpm::document_t& base, const cpm::document_t& doc){
-    return  str_equal(doc["tag"].GetString(), base["tag"].GetString())
-        &&  str_equal(doc["configuration"].GetString(), base["configuration"].GetString());
-}
-
-bool is_configuration_relevant(const cpm::document_t& base, const cpm::document_t& doc){
-    return  str_equal(doc["tag"].GetString(), base["tag"].GetString())
-        &&  str_equal(doc["compiler"].GetString(), base["compiler"].GetString());
-}
-
-auto compiler_filter(const cpm::document_t& base){
-    return [&base](const cpm::document_t& doc){
-        return is_compiler_relevant(base, doc);
+auto compiler_filter(const cpm::report_run& base){
+    return [&base](const cpm::report_run& run){
+        return is_compiler_relevant(base, run);
     };
 }
 
-auto configuration_filter(const cpm::document_t& base){
-    return [&base](const cpm::document_t& doc){
-        return is_configuration_relevant(base, doc);
+auto configuration_filter(const cpm::report_run& base){
+    return [&base](const cpm::report_run& run){
+        return is_configuration_relevant(base, run);
     };
 }
 
 template<typename Theme>
-void generate_compiler_graph(Theme& theme, std::size_t& id, const rapidjson::Value& base_result, const cpm::document_t& base){
-    generate_compare_graph(theme, id, base_result, "Compiler", "compiler", compiler_filter(base));
+void generate_compiler_graph(Theme& theme, std::size_t& id, const cpm::report_series& base_result, const cpm::report_run& base){
+    generate_compare_graph(theme, id, base_result, "Compiler", "compiler", base);
 }
 
 template<typename Theme>
-void generate_configuration_graph(Theme& theme, std::size_t& id, const rapidjson::Value& base_result, const cpm::document_t& base){
-    generate_compare_graph(theme, id, base_result, "Configuration", "configuration", configuration_filter(base));
+void generate_configuration_graph(Theme& theme, std::size_t& id, const cpm::report_series& base_result, const cpm::report_run& base){
+    generate_compare_graph(theme, id, base_result, "Configuration", "configuration", base);
 }
 
+//Find the value of the same size in the given series of another run
 template<typename Theme>
-std::pair<bool, double> find_same_duration(Theme& theme, const rapidjson::Value& base_result, const rapidjson::Value& r, const cpm::document_t& doc){
-    for(auto& p_r : doc["results"]){
-        if(strip_equal(p_r["title"].GetString(), base_result["title"].GetString())){
-            for(auto& p_r_r : p_r["results"]){
-                if(str_equal(p_r_r["size"].GetString(), r["size"].GetString())){
-                    return std::make_pair(true, p_r_r[value_key_name(theme)].GetDouble());
-                }
-            }
+std::pair<bool, double> find_same_duration(Theme& theme, const cpm::report_series* series, std::size_t point){
+    auto& data = theme.data;
+
+    if(series){
+        auto i = data.find_point(*series, data.sizes[point]);
+
+        if(i != cpm::no_index){
+            return std::make_pair(true, data.value(value_metric(theme), i));
         }
     }
 
-    return std::make_pair(false, 0);
+    return std::make_pair(false, 0.0);
+}
+
+//The series of a run corresponding to a bench (or to an implementation of a section)
+const cpm::report_series* same_series(const cpm::reports_data& data, const cpm::report_run& run, const cpm::report_section* base_section, const cpm::report_series& base_result){
+    if(!base_section){
+        return data.find_result(run, base_result.title);
+    }
+
+    auto section = data.find_section(run, base_section->name);
+    return section ? data.find_implementation(*section, base_result.title) : nullptr;
 }
 
 template<typename Theme>
@@ -480,13 +911,13 @@ double add_compare_cell(Theme& theme, double current, double previous){
 }
 
 template<typename Theme>
-std::pair<bool,double> compare(Theme& theme, const rapidjson::Value& base_result, const rapidjson::Value& r, const cpm::document_t& doc){
+std::pair<bool,double> compare(Theme& theme, const cpm::report_series* series, std::size_t point){
     bool found;
     int previous;
-    std::tie(found, previous) = find_same_duration(theme, base_result, r, doc);
+    std::tie(found, previous) = find_same_duration(theme, series, point);
 
     if(found){
-        auto current = r[value_key_name(theme)].GetDouble();
+        auto current = theme.data.value(value_metric(theme), point);
 
         double diff = add_compare_cell(theme, current, previous);
         return std::make_pair(true, diff);
@@ -547,9 +978,72 @@ void summary_footer(Theme& theme, double previous_acc, double first_acc){
     theme << "</tr>\n";
 }
 
+using run_series = std::vector<std::pair<const cpm::report_run*, const cpm::report_series*>>;
+
+//The series of the relevant runs corresponding to the base series
+template<typename Filter>
+run_series relevant_series(const cpm::reports_data& data, const cpm::report_section* base_section, const cpm::report_series& base_result, Filter f){
+    run_series relevant;
+
+    for(auto& run : data.runs){
+        if(f(run)){
+            auto series = same_series(data, run, base_section, base_result);
+
+            if(series){
+                relevant.emplace_back(&run, series);
+            }
+        }
+    }
+
+    return relevant;
+}
+
+//Cells of the best run, among the relevant ones, for the given point
 template<typename Theme>
-void generate_summary_table(Theme& theme, const rapidjson::Value& base_result, const cpm::document_t& base){
-    theme.before_summary();
+void best_cells(Theme& theme, std::size_t point, const cpm::report_run& base, std::uint32_t cpm::report_run::*attr, const run_series& relevant){
+    auto& data = theme.data;
+
+    bool flops = theme.options.count("mflops");
+
+    std::string best_name = data.str(base.*attr);
+    auto best = data.value(value_metric(theme), point);
+    auto worst = data.value(value_metric(theme), point);
+
+    for(auto& r : relevant){
+        bool found;
+        int duration;
+        std::tie(found, duration) = find_same_duration(theme, r.second, point);
+
+        if(found){
+            if(flops){
+                if(duration > best){
+                    best = duration;
+                    best_name = data.str(r.first->*attr);
+                } else if(duration < worst){
+                    worst = duration;
+                }
+            } else {
+                if(duration < best){
+                    best = duration;
+                    best_name = data.str(r.first->*attr);
+                } else if(duration > worst){
+                    worst = duration;
+                }
+            }
+        }
+    }
+
+    theme.cell(best_name);
+
+    auto max_diff = std::abs(100.0 * (static_cast<double>(worst) / best) - 100.0);
+
+    theme.cell(std::to_string(max_diff) + "%");
+}
+
+//Rows of the summary of a bench (or of an implementation of a section)
+template<typename Theme>
+void summary_rows(Theme& theme, const cpm::report_section* base_section, const cpm::report_series& base_result, const cpm::report_run& base, const std::vector<std::size_t>& runs){
+    auto& data = theme.data;
 
     summary_header(theme);
 
@@ -558,44 +1052,59 @@ void generate_summary_table(Theme& theme, const rapidjson::Value& base_result, c
 
     bool flops = theme.options.count("mflops");
 
-    for(auto& r : base_result["results"]){
+    //The series to compare with are resolved once for all the sizes
+    const cpm::report_series* previous_series = nullptr;
+    const cpm::report_series* first_series = nullptr;
+
+    for(std::size_t i = 0; i + 1 < runs.size(); ++i){
+        if(&data.runs[runs[i + 1]] == &base){
+            previous_series = same_series(data, data.runs[runs[i]], base_section, base_result);
+            break;
+        }
+    }
+
+    if(runs.size() > 1){
+        first_series = same_series(data, data.runs[runs[0]], base_section, base_result);
+    }
+
+    run_series compilers;
+    run_series configurations;
+
+    if(data.compilers.size() > 1){
+        compilers = relevant_series(data, base_section, base_result, compiler_filter(base));
+    }
+
+    if(data.configurations.size() > 1){
+        configurations = relevant_series(data, base_section, base_result, configuration_filter(base));
+    }
+
+    for(std::size_t point = base_result.first; point < base_result.first + base_result.count; ++point){
         theme << "<tr>\n";
 
-        theme << "<td>" << r["size"].GetString() << "</td>\n";
-        theme << "<td>" << r["mean"].GetDouble() << "</td>\n";
+        theme << "<td>" << data.str(data.sizes[point]) << "</td>\n";
+        theme << "<td>" << data.value(cpm::METRIC_MEAN, point) << "</td>\n";
 
         if(flops){
-            theme << "<td>" << cpm::throughput_str(r["throughput_f"].GetDouble()) << "</td>\n";
+            theme << "<td>" << cpm::throughput_str(data.value(cpm::METRIC_THROUGHPUT_F, point)) << "</td>\n";
         } else {
-            theme << "<td>" << cpm::throughput_str(r["throughput_e"].GetDouble()) << "</td>\n";
+            theme << "<td>" << cpm::throughput_str(data.value(cpm::METRIC_THROUGHPUT_E, point)) << "</td>\n";
         }
 
         bool previous_found = false;
         double diff = 0.0;
 
-        auto documents = select_documents(theme.data.documents, base);
+        std::tie(previous_found, diff) = compare(theme, previous_series, point);
 
-        for(std::size_t i = 0; i < documents.size() - 1; ++i){
-            if(&static_cast<const cpm::document_t&>(documents[i+1]) == &base){
-                auto& doc = static_cast<const cpm::document_t&>(documents[i]);
-                std::tie(previous_found, diff) = compare(theme, base_result, r, doc);
-
-                if(previous_found){
-                    previous_acc += diff;
-                    break;
-                }
-            }
-        }
-
-        if(!previous_found){
+        if(previous_found){
+            previous_acc += diff;
+        } else {
             theme.cell("N/A");
         }
 
         previous_found = false;
 
-        if(documents.size() > 1){
-            auto& doc = static_cast<const cpm::document_t&>(documents[0]);
-            std::tie(previous_found, diff) = compare(theme, base_result, r, doc);
+        if(runs.size() > 1){
+            std::tie(previous_found, diff) = compare(theme, first_series, point);
 
             first_acc += diff;
         }
@@ -604,720 +1113,1696 @@ void generate_summary_table(Theme& theme, const rapidjson::Value& base_result, c
             theme.cell("N/A");
         }
 
-        if(theme.data.compilers.size() > 1){
-            std::string best_compiler = base["compiler"].GetString();
-            auto best = r[value_key_name(theme)].GetDouble();
-            auto worst = r[value_key_name(theme)].GetDouble();
-
-            for(auto& doc : theme.data.documents){
-                if(is_compiler_relevant(base, doc)){
-                    bool found;
-                    int duration;
-                    std::tie(found, duration) = find_same_duration(theme, base_result, r, doc);
-
-                    if(found){
-                        if(flops){
-                            if(duration > best){
-                                best = duration;
-                                best_compiler = doc["compiler"].GetString();
-                            } else if(duration < worst){
-                                worst = duration;
-                            }
-                        } else {
-                            if(duration < best){
-                                best = duration;
-                                best_compiler = doc["compiler"].GetString();
-                            } else if(duration > worst){
-                                worst = duration;
-                            }
-                        }
-                    }
-                }
-            }
-
-            theme.cell(best_compiler);
-
-            auto max_diff = std::abs(100.0 * (static_cast<double>(worst) / best) - 100.0);
-
-            theme.cell(std::to_string(max_diff) + "%");
-        }
-
-        if(theme.data.configurations.size() > 1){
-            std::string best_configuration = base["configuration"].GetString();
-            auto best = r[value_key_name(theme)].GetDouble();
-            auto worst = r[value_key_name(theme)].GetDouble();
-
-            for(auto& doc : theme.data.documents){
-                if(is_configuration_relevant(base, doc)){
-                    bool found;
-                    int duration;
-                    std::tie(found, duration) = find_same_duration(theme, base_result, r, doc);
-
-                    if(found){
-                        if(flops){
-                            if(duration > best){
-                                best = duration;
-                                best_configuration = doc["configuration"].GetString();
-                            } else if(duration < worst){
-                                worst = duration;
-                            }
-                        } else {
-                            if(duration < best){
-                                best = duration;
-                                best_configuration = doc["configuration"].GetString();
-                            } else if(duration > worst){
-                                worst = duration;
-                            }
-                        }
-                    }
-                }
-            }
-
-            theme.cell(best_configuration);
-
-            auto max_diff = std::abs(100.0 * (static_cast<double>(worst) / best) - 100.0);
+        if(data.compilers.size() > 1){
+            best_cells(theme, point, base, &cpm::report_run::compiler, compilers);
+        }
 
-            theme.cell(std::to_string(max_diff) + "%");
+        if(data.configurations.size() > 1){
+            best_cells(theme, point, base, &cpm::report_run::configuration, configurations);
         }
 
         theme << "</tr>\n";
     }
 
-    previous_acc /= base_result["results"].Size();
-    first_acc /= base_result["results"].Size();
+    previous_acc /= base_result.count;
+    first_acc /= base_result.count;
 
     summary_footer(theme, previous_acc, first_acc);
+}
+
+template<typename Theme>
+void generate_summary_table(Theme& theme, const cpm::report_series& base_result, const cpm::report_run& base, const std::vector<std::size_t>& runs){
+    theme.before_summary();
+
+    summary_rows(theme, nullptr, base_result, base, runs);
 
     theme.after_summary();
 }
 
 template<typename Theme>
-void generate_time_graph(Theme& theme, std::size_t& id, const rapidjson::Value& result, const std::vector<cpm::document_cref>& documents){
+void generate_time_graph(Theme& theme, std::size_t& id, const cpm::report_series& result, const cpm::report_run& base){
+    auto& name = theme.data.str(result.title);
+
+    theme.before_graph(id);
+
+    lazy_chart(theme, std::string("chart_") + std::to_string(id), "time", base, false, name,
+        "Time" + (theme.options.count("pages") ? std::string() : std::string(": ") + name));
+
+    theme.after_graph();
+    ++id;
+}
+
+template<typename Theme>
+void generate_section_run_graph(Theme& theme, std::size_t& id, const cpm::report_section& section, const cpm::report_run& base){
+    auto& name = theme.data.str(section.name);
+
+    theme.before_graph(id);
+
+    lazy_chart(theme, std::string("chart_") + std::to_string(id), "run", base, true, name,
+        "Last run" + (theme.options.count("pages") ? std::string() : std::string(": ") + name));
+
+    theme.after_graph();
+    ++id;
+}
+
+template<typename Theme>
+void generate_section_time_graph(Theme& theme, std::size_t& id, const cpm::report_section& section, const cpm::report_run& base){
+    auto& name = theme.data.str(section.name);
+
     theme.before_graph(id);
 
-    std::string graph_title = "Time" +
-        (theme.options.count("pages") ? std::string() : std::string(": ") + strip_tags(result["title"].GetString()));
-    start_graph(theme, std::string("chart_") + std::to_string(id), graph_title);
+    lazy_chart(theme, std::string("chart_") + std::to_string(id), "time", base, true, name,
+        "Time" + (theme.options.count("pages") ? std::string() : std::string(": ") + name));
+
+    theme.after_graph();
+    ++id;
+}
+
+template<typename Theme>
+void generate_section_compare_graph(Theme& theme, std::size_t& id, const cpm::report_section& section, const std::string& title, const char* graph, const cpm::report_run& base){
+    auto& data = theme.data;
+    auto& name = data.str(section.name);
+
+    std::size_t sub_id = 0;
+
+    theme.before_sub_graphs(id, title_collect(data, data.implementations(section)));
+
+    for(auto& r : data.implementations(section)){
+        theme.before_sub_graph(id, sub_id++);
+
+        lazy_chart(theme, std::string("chart_") + std::to_string(id) + "-" + std::to_string(sub_id - 1), graph, base, true, name,
+            title + name + "-" + data.str(r.title), data.str(r.title));
+
+        theme.after_sub_graph();
+    }
+
+    theme.after_sub_graphs();
+
+    ++id;
+}
+
+template<typename Theme>
+void generate_section_compiler_graph(Theme& theme, std::size_t& id, const cpm::report_section& section, const cpm::report_run& base){
+    generate_section_compare_graph(theme, id, section, "Compiler:", "compiler", base);
+}
+
+template<typename Theme>
+void generate_section_configuration_graph(Theme& theme, std::size_t& id, const cpm::report_section& section, const cpm::report_run& base){
+    generate_section_compare_graph(theme, id, section, "Configuration:", "configuration", base);
+}
+
+template<typename Theme>
+void generate_section_summary_table(Theme& theme, std::size_t id, const cpm::report_section& base_section, const cpm::report_run& base, const std::vector<std::size_t>& runs){
+    auto& data = theme.data;
+
+    std::size_t sub_id = 0;
+    theme.before_sub_graphs(id * 1000000, title_collect(data, data.implementations(base_section)));
 
-    theme << "xAxis: { type: 'datetime', title: { text: 'Date' } },\n";
+    for(auto& base_result : data.implementations(base_section)){
+        theme.before_sub_summary(id * 1000000, sub_id++);
 
-    y_axis_configuration(theme);
+        summary_rows(theme, &base_section, base_result, base, runs);
 
-    if(!theme.options.count("time-sizes")){
-        theme << "legend: { enabled: false },\n";
+        theme.after_sub_summary();
     }
 
-    theme << "series: [\n";
+    theme.after_sub_graphs();
+}
 
-    if(theme.options.count("time-sizes")){
-        std::string comma = "";
-        for(auto& r : result["results"]){
-            theme << comma << "{\n";
+template<typename Theme>
+bool generate_standard_page(const std::string& target_folder, const std::string& file, const cpm::reports_data& data, const cpm::report_run& run, const std::vector<std::size_t>& runs, cxxopts::Options& options, bool one = false, bool section = false, const std::string& filter = ""){
+    bool time_graphs = !options.count("disable-time") && runs.size() > 1;
+    bool compiler_graphs = !options.count("disable-compiler") && data.compilers.size() > 1;
+    bool configuration_graphs = !options.count("disable-configuration") && data.configurations.size() > 1;
+    bool summary_table = !options.count("disable-summary");
 
-            theme << "name: '" << r["size"].GetString() << "',\n";
-            theme << "data: [";
+    //The buffer of each thread is reused for all its pages
+    static thread_local cpm::page_buffer stream;
+    stream.clear();
 
-            std::string inner_comma = "";
+    cpm::report_page page;
 
-            for(auto& document_r : documents){
-                auto& document = static_cast<const cpm::document_t&>(document_r);
+    Theme theme(data, page, options, stream, data.str(run.compiler), data.str(run.configuration));
 
-                for(auto& o_result : document["results"]){
-                    if(strip_equal(o_result["title"].GetString(), result["title"].GetString())){
-                        for(auto& o_rr : o_result["results"]){
-                            if(o_rr["size"].GetString() == r["size"].GetString()){
-                                theme << inner_comma << "[" << size_t(document["timestamp"].GetInt()) * 1000 << ",";
-                                theme << o_rr[value_key_name(theme)].GetDouble() << "]";
-                                inner_comma = ",";
-                            }
-                        }
-                    }
+    //Header of the page
+    header(theme);
+
+    //Configure the highcharts theme
+    if(options["hctheme"].as<std::string>() == "dark_unica"){
+        theme << "<script>\n" << "\n";
+        theme << dark_unica_theme << "\n";
+        theme << "</script>\n";
+    }
+
+    if(one){
+        page.file = file;
+
+        if(section){
+            page.sub_part = std::string("section_") + filter;
+        } else {
+            page.sub_part = std::string("bench_") + filter;
+        }
+
+        page.files.clear();
+
+        for(const auto& result : data.results(run)){
+            auto& name = data.str(result.title);
+            page.files.emplace_back(name, cpm::filify(data.str(run.compiler), data.str(run.configuration), std::string("bench_") + name));
+        }
+
+        for(const auto& section : data.run_sections(run)){
+            auto& name = data.str(section.name);
+            page.files.emplace_back(name, cpm::filify(data.str(run.compiler), data.str(run.configuration), std::string("section_") + name));
+        }
+    }
+
+    //Information block about the last run
+    information(theme, run);
+
+    //Compiler selection
+    compiler_buttons(theme);
+
+    //Configuration selection
+    configuration_buttons(theme);
+
+    //More informations for some theme (navigation list for instance)
+    after_buttons(theme);
+
+    std::size_t id = 1;
+
+    if(!one || !section){
+        for(const auto& result : data.results(run)){
+            if(!one || filter == data.str(result.title)){
+                theme << "<a id=\"" << result_anchor(false, data.str(result.title)) << "\"></a>\n";
+
+                theme.before_result(data.str(result.title), false, runs);
+
+                generate_run_graph(theme, id, result, run);
+
+                if(time_graphs){
+                    generate_time_graph(theme, id, result, run);
+                }
+
+                if(compiler_graphs){
+                    generate_compiler_graph(theme, id, result, run);
+                }
+
+                if(configuration_graphs){
+                    generate_configuration_graph(theme, id, result, run);
+                }
+
+                if(summary_table){
+                    generate_summary_table(theme, result, run, runs);
                 }
-            }
 
-            theme << "]\n";
-            theme << "}\n";
-            comma =",";
+                theme.after_result();
+            }
         }
-    } else {
-        theme << "{\n";
+    }
+
+    if(!one || section){
+        for(auto& section : data.run_sections(run)){
+            if(!one || filter == data.str(section.name)){
+                theme << "<a id=\"" << result_anchor(true, data.str(section.name)) << "\"></a>\n";
 
-        theme << "name: '',\n";
-        theme << "data: [";
+                theme.before_result(data.str(section.name), compiler_graphs, runs);
 
-        std::string comma = "";
+                generate_section_run_graph(theme, id, section, run);
 
-        for(auto& document_r : documents){
-            auto& document = static_cast<const cpm::document_t&>(document_r);
+                if(time_graphs){
+                    generate_section_time_graph(theme, id, section, run);
+                }
+
+                if(compiler_graphs){
+                    generate_section_compiler_graph(theme, id, section, run);
+                }
+
+                if(configuration_graphs){
+                    generate_section_configuration_graph(theme, id, section, run);
+                }
 
-            for(auto& o_result : document["results"]){
-                if(strip_equal(o_result["title"].GetString(), result["title"].GetString())){
-                    theme << comma << "[" << size_t(document["timestamp"].GetInt()) * 1000 << ",";
-                    auto& o_r_results = o_result["results"];
-                    theme << o_r_results[o_r_results.Size() - 1][value_key_name(theme)].GetDouble() << "]";
-                    comma = ",";
+                if(summary_table){
+                    generate_section_summary_table(theme, id, section, run, runs);
                 }
+
+                theme.after_result();
             }
         }
+    }
+
+    footer(theme);
+
+    return stream.write(target_folder + "/" + file);
+}
 
-        theme << "]\n";
-        theme << "}\n";
+//Signature of the inputs shared by all the pages
+std::uint64_t report_signature(const cpm::reports_data& data, cxxopts::Options& options){
+    std::string inputs = "cpm-report-3";
+
+    for(auto option : {"time-sizes", "sort-by-tag", "pages", "mflops", "mflops-graphs", "disable-time", "disable-compiler", "disable-configuration", "disable-summary"}){
+        inputs += options.count(option) ? '1' : '0';
     }
 
-    theme << "]\n";
+    inputs += '\0' + options["theme"].as<std::string>() + '\0' + options["hctheme"].as<std::string>();
 
-    end_graph(theme);
-    theme.after_graph();
-    ++id;
+    for(auto& compiler : data.compilers){
+        inputs += '\0' + compiler;
+    }
+
+    for(auto& configuration : data.configurations){
+        inputs += '\0' + configuration;
+    }
+
+    inputs += '\0' + data.str(data.runs.back().name) + (data.runs.size() > 1 ? '1' : '0');
+
+    return cpm::fnv1a(inputs);
 }
 
-std::vector<std::string> gather_sizes(const rapidjson::Value& section){
-    std::vector<std::string> sizes;
-    std::set<std::string> set_sizes;
+//Signature of the inputs of a page, in addition to its groups of results
+std::uint64_t page_signature(const cpm::reports_data& data, std::uint64_t report, const cpm::report_run& run, bool one, bool section, const std::string& filter){
+    std::string inputs = std::to_string(report) + '\0' + std::to_string(run.timestamp);
 
-    for(auto& r : section["results"]){
-        for(auto& rr : r["results"]){
-            auto s = rr["size"].GetString();
-            if(!set_sizes.count(s)){
-                set_sizes.insert(s);
-                sizes.push_back(s);
-            }
+    for(auto id : {run.name, run.tag, run.compiler, run.configuration, run.os, run.time}){
+        inputs += '\0' + data.str(id);
+    }
+
+    //The navigation of a single page lists the benches and the sections of its run
+    if(one){
+        inputs += std::string(section ? "\1section\1" : "\1bench\1") + filter;
+
+        for(auto& result : data.results(run)){
+            inputs += '\0' + data.str(result.title);
+        }
+
+        for(auto& s : data.run_sections(run)){
+            inputs += '\1' + data.str(s.name);
         }
     }
 
-    return sizes;
+    return cpm::fnv1a(inputs);
 }
 
-template<typename Theme>
-void generate_section_run_graph(Theme& theme, std::size_t& id, const rapidjson::Value& section){
-    theme.before_graph(id);
+//Results of a bench (or of a section) in all the runs, written in one data file
+struct data_group {
+    bool section;
+    std::uint32_t name;
+    std::vector<std::pair<std::size_t, const cpm::report_series*>> series; //(run, series)
+};
+
+//Local index of a value in the data file of a group
+std::size_t data_local(std::vector<std::uint32_t>& values, std::unordered_map<std::uint32_t, std::size_t>& ids, std::uint32_t value){
+    auto it = ids.find(value);
 
-    std::string graph_title = "Last run" +
-        (theme.options.count("pages") ? std::string() : std::string(": ") + strip_tags(section["name"].GetString()));
-    start_graph(theme, std::string("chart_") + std::to_string(id), graph_title);
+    if(it != ids.end()){
+        return it->second;
+    }
 
-    theme << "xAxis: { categories: \n";
+    ids.emplace(value, values.size());
+    values.push_back(value);
 
-    auto sizes = gather_sizes(section);
+    return values.size() - 1;
+}
 
-    json_array_string(theme, sizes);
+void write_strings(cpm::page_buffer& stream, const cpm::reports_data& data, const std::vector<std::uint32_t>& values){
+    stream << '[';
 
-    theme << "},\n";
+    for(std::size_t i = 0; i < values.size(); ++i){
+        stream << (i ? "," : "") << js_string(data.str(values[i]));
+    }
 
-    y_axis_configuration(theme);
+    stream << ']';
+}
 
-    theme << "legend: { align: 'left', verticalAlign: 'top', floating: false, borderWidth: 0, y: 20 },\n";
+//The time series of the group, the indices of the series of each compiler, configuration and implementation by time
+std::vector<std::vector<std::size_t>> time_sequences(const cpm::reports_data& data, const data_group& group){
+    std::map<std::tuple<std::uint32_t, std::uint32_t, std::uint32_t>, std::vector<std::size_t>> sequences;
 
-    theme << "series: [\n";
+    for(std::size_t j = 0; j < group.series.size(); ++j){
+        auto& run = data.runs[group.series[j].first];
+        sequences[std::make_tuple(run.compiler, run.configuration, group.series[j].second->title)].push_back(j);
+    }
 
-    std::string comma = "";
-    for(auto& r : section["results"]){
-        theme << comma << "{\n";
+    std::vector<std::vector<std::size_t>> result;
 
-        theme << "name: '" << strip_tags(r["name"].GetString()) << "',\n";
-        theme << "data: ";
+    for(auto& sequence : sequences){
+        auto indices = std::move(sequence.second);
 
-        json_array_value(theme, double_collect(r["results"], value_key_name(theme)));
+        std::stable_sort(indices.begin(), indices.end(), [&](std::size_t lhs, std::size_t rhs){
+            return data.runs[group.series[lhs].first].timestamp < data.runs[group.series[rhs].first].timestamp;
+        });
 
-        theme << "\n}\n";
-        comma = ",";
+        result.push_back(std::move(indices));
     }
 
-    theme << "]\n";
+    return result;
+}
 
-    end_graph(theme);
-    theme.after_graph();
-    ++id;
+//The value of a series in the time graphs
+double time_value(const cpm::reports_data& data, const cpm::report_series& s, cpm::report_metric metric){
+    return s.count ? data.value(metric, s.first + s.count - 1) : 0.0;
 }
 
-template<typename Theme>
-void generate_section_time_graph(Theme& theme, std::size_t& id, const rapidjson::Value& section, const std::vector<cpm::document_cref>& documents){
-    theme.before_graph(id);
+//Select the series shown in the time graphs, each time series of the group is downsampled on its last values
+std::vector<bool> time_points(const cpm::reports_data& data, const data_group& group, cpm::report_metric metric, std::size_t max_points, cpm::downsampling method){
+    std::vector<bool> kept(group.series.size(), true);
+
+    for(auto& indices : time_sequences(data, group)){
+        if(indices.size() <= max_points){
+            continue;
+        }
 
-    std::string graph_title = "Time" +
-        (theme.options.count("pages") ? std::string() : std::string(": ") + strip_tags(section["name"].GetString()));
-    start_graph(theme, std::string("chart_") + std::to_string(id), graph_title);
+        std::vector<cpm::time_point> points;
 
-    theme << "xAxis: { type: 'datetime', title: { text: 'Date' } },\n";
+        for(auto j : indices){
+            points.push_back({double(data.runs[group.series[j].first].timestamp), time_value(data, *group.series[j].second, metric)});
+        }
+
+        auto selected = cpm::downsample(points, max_points, 5, method);
+
+        for(std::size_t i = 0; i < indices.size(); ++i){
+            kept[indices[i]] = selected[i];
+        }
+    }
+
+    return kept;
+}
+
+//Shift of the performance of a bench (or of an implementation of a section)
+struct report_shift {
+    bool section;
+    std::uint32_t name;   //Bench or section
+    std::uint32_t impl;   //Implementation of the section
+    std::size_t run;      //First run after the shift
+    std::size_t series;   //First series after the shift in its group
+    double before;        //Mean time before the shift
+    double after;         //Mean time after the shift
+    bool recent;          //The shift happened in the latest runs
+
+    bool regression() const {
+        return after > before;
+    }
+};
+
+//Number of the latest runs of a time series where a shift is recent
+constexpr const std::size_t recent_runs = 5;
+
+//Detect the shifts of the time of each time series of the group
+std::vector<report_shift> detect_shifts(const cpm::reports_data& data, const data_group& group, double threshold){
+    std::vector<report_shift> shifts;
+
+    for(auto& indices : time_sequences(data, group)){
+        std::vector<double> values;
+
+        for(auto j : indices){
+            values.push_back(time_value(data, *group.series[j].second, cpm::METRIC_MEAN));
+        }
+
+        for(auto& change : cpm::detect_changes(values, threshold)){
+            auto j = indices[change.index];
+
+            shifts.push_back({group.section, group.name, group.series[j].second->title, group.series[j].first, j,
+                change.before, change.after, change.index + recent_runs >= indices.size()});
+        }
+    }
+
+    return shifts;
+}
+
+bool write_data_group(const std::string& target_folder, const std::string& file, const cpm::reports_data& data, const data_group& group, const std::vector<report_shift>& shifts,
+                      const std::vector<std::string>& run_ids, cpm::report_metric metric, std::size_t max_points, cpm::downsampling method){
+    static thread_local cpm::page_buffer stream;
+    stream.clear();
+
+    auto kept = time_points(data, group, metric, max_points, method);
+
+    std::vector<std::uint32_t> sizes;
+    std::vector<std::uint32_t> regimes;
+    std::vector<std::uint32_t> impls;
+
+    std::unordered_map<std::uint32_t, std::size_t> size_ids;
+    std::unordered_map<std::uint32_t, std::size_t> regime_ids;
+    std::unordered_map<std::uint32_t, std::size_t> impl_ids;
+
+    for(auto& s : group.series){
+        data_local(impls, impl_ids, s.second->title);
+
+        for(std::uint32_t i = s.second->first; i < s.second->first + s.second->count; ++i){
+            data_local(sizes, size_ids, data.sizes[i]);
+
+            if(data.regimes[i] != cpm::no_string){
+                data_local(regimes, regime_ids, data.regimes[i]);
+            }
+        }
+    }
+
+    stream << "cpm.data('" << file << "', {\n";
+
+    stream << "sizes: ";
+    write_strings(stream, data, sizes);
+    stream << ",\nregimes: ";
+    write_strings(stream, data, regimes);
+    stream << ",\nimpls: ";
+    write_strings(stream, data, impls);
+    stream << ",\nseries: [\n";
+
+    for(std::size_t j = 0; j < group.series.size(); ++j){
+        auto& s = *group.series[j].second;
+        auto last = s.first + s.count;
+
+        stream << "['" << run_ids[group.series[j].first] << "'," << impl_ids[s.title] << ",[";
+
+        for(auto i = s.first; i < last; ++i){
+            stream << (i == s.first ? "" : ",") << size_ids[data.sizes[i]];
+        }
+
+        stream << "],[";
+
+        for(auto i = s.first; i < last; ++i){
+            stream << (i == s.first ? "" : ",") << data.value(metric, i);
+        }
+
+        stream << "],";
+
+        if(s.count && data.regimes[s.first] != cpm::no_string){
+            stream << '[';
+
+            for(auto i = s.first; i < last; ++i){
+                stream << (i == s.first ? "" : ",") << (data.regimes[i] == cpm::no_string ? -1 : static_cast<long>(regime_ids[data.regimes[i]]));
+            }
+
+            stream << ']';
+        } else {
+            stream << '0';
+        }
+
+        stream << ',' << (kept[j] ? '1' : '0') << (j + 1 < group.series.size() ? "],\n" : "]\n");
+    }
+
+    stream << "],\nshifts: [";
+
+    for(std::size_t i = 0; i < shifts.size(); ++i){
+        stream << (i ? ",\n" : "\n") << "['" << run_ids[shifts[i].run] << "'," << impl_ids[shifts[i].impl] << ',' << shifts[i].before << ',' << shifts[i].after << ']';
+    }
+
+    stream << "\n]});\n";
+
+    return stream.write(target_folder + "/" + file);
+}
+
+/*
+ * Generate the data files shared by all the pages: the client script of the
+ * charts, the list of the runs, the search index and one data file per bench
+ * (or section) with its results in all the runs. Only the data files of the
+ * changed groups are written again. Returns the shifts detected in all the
+ * groups.
+ */
+std::vector<report_shift> generate_data(const std::string& target_folder, const cpm::reports_data& data, cxxopts::Options& options, cpm::report_cache& cache, const cpm::report_changes& changes){
+    auto data_folder = target_folder + "/data";
+
+    if(mkdir(data_folder.c_str(), 0755) != 0 && errno != EEXIST){
+        std::cout << "cpm: Unable to create the data folder" << std::endl;
+        return {};
+    }
+
+    cpm::page_buffer stream;
+
+    stream << charts_script;
+    stream.write(data_folder + "/cpm.js");
+
+    //The runs, in the order of the report
+
+    std::vector<std::string> run_ids;
+
+    stream.clear();
+    stream << "cpm.runs([\n";
+
+    for(auto& run : data.runs){
+        run_ids.push_back(run_id(data, run));
+
+        stream << (run_ids.size() > 1 ? ",\n" : "") << "['" << run_ids.back() << "'," << js_string(data.str(run.tag)) << ","
+            << js_string(data.str(run.compiler)) << "," << js_string(data.str(run.configuration)) << "," << run.timestamp << "]";
+    }
+
+    stream << "\n]);\n";
+    stream.write(data_folder + "/runs.js");
+
+    //The search index points to the page (or the anchor) of each bench and section
+
+    std::set<std::string> indexed;
+
+    stream.clear();
+    stream << "cpm.index([\n";
+
+    auto entry = [&](const cpm::report_run& run, const std::string& name, bool section){
+        auto& compiler = data.str(run.compiler);
+        auto& configuration = data.str(run.configuration);
+
+        std::string href;
+        if(options.count("pages")){
+            href = cpm::filify(compiler, configuration, (section ? "section_" : "bench_") + name);
+        } else {
+            href = cpm::filify(compiler, configuration) + "#" + result_anchor(section, name);
+        }
+
+        if(indexed.insert(href).second){
+            stream << (indexed.size() > 1 ? ",\n" : "") << '[' << js_string(name) << ',' << js_string(compiler) << ',' << js_string(configuration) << ',' << js_string(href) << ']';
+        }
+    };
+
+    std::set<std::pair<std::uint32_t, std::uint32_t>> latest;
+
+    std::for_each(data.runs.rbegin(), data.runs.rend(), [&](const cpm::report_run& run){
+        //Without pages, only the latest run of a compiler and configuration has a page
+        if(!options.count("pages") && !latest.emplace(run.compiler, run.configuration).second){
+            return;
+        }
+
+        for(auto& result : data.results(run)){
+            entry(run, data.str(result.title), false);
+        }
+
+        for(auto& section : data.run_sections(run)){
+            entry(run, data.str(section.name), true);
+        }
+    });
+
+    stream << "\n]);\n";
+    stream.write(data_folder + "/index.js");
+
+    //The groups of results, the first series of a run wins like in the pages
+
+    std::map<std::pair<bool, std::uint32_t>, data_group> groups;
+
+    for(std::size_t r = 0; r < data.runs.size(); ++r){
+        auto& run = data.runs[r];
+
+        for(auto& result : data.results(run)){
+            if(data.find_result(run, result.title) == &result){
+                auto& group = groups[{false, result.title}];
+                group.section = false;
+                group.name = result.title;
+                group.series.emplace_back(r, &result);
+            }
+        }
+
+        for(auto& section : data.run_sections(run)){
+            if(data.find_section(run, section.name) != &section){
+                continue;
+            }
+
+            auto& group = groups[{true, section.name}];
+            group.section = true;
+            group.name = section.name;
+
+            for(auto& implementation : data.implementations(section)){
+                if(data.find_implementation(section, implementation.title) == &implementation){
+                    group.series.emplace_back(r, &implementation);
+                }
+            }
+        }
+    }
+
+    auto max_points = options["time-points"].as<std::size_t>();
+    auto method = options["downsampling"].as<std::string>() == "minmax" ? cpm::downsampling::MIN_MAX : cpm::downsampling::LTTB;
+
+    auto threshold = options["regression-threshold"].as<double>() / 100.0;
+
+    auto signature = cpm::fnv1a(std::string("cpm-data-3") + (options.count("mflops-graphs") ? '1' : '0')
+        + '\0' + std::to_string(max_points) + '\0' + options["downsampling"].as<std::string>() + '\0' + std::to_string(threshold));
+    auto metric = options.count("mflops-graphs") ? cpm::METRIC_THROUGHPUT_F : cpm::METRIC_MEAN;
+
+    //The shifts are needed for all the groups, for the regressions page
+    std::vector<const data_group*> all;
+    for(auto& group : groups){
+        all.push_back(&group.second);
+    }
+
+    std::vector<std::vector<report_shift>> shifts(all.size());
+
+    cpm::parallel_for(all.size(), [&](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            shifts[i] = detect_shifts(data, *all[i], threshold);
+        }
+    }, 1);
+
+    std::vector<std::tuple<std::string, std::size_t, cpm::cache_page>> jobs;
+
+    for(std::size_t i = 0; i < all.size(); ++i){
+        auto& name = data.str(all[i]->name);
+        auto file = data_file(all[i]->section, name);
+
+        cpm::cache_page entry{"", "", name, signature};
+
+        if(cache.dirty(file, entry, changes, target_folder)){
+            jobs.emplace_back(file, i, std::move(entry));
+        } else {
+            cache.generated(file, std::move(entry));
+        }
+    }
+
+    std::vector<char> written(jobs.size());
+
+    cpm::parallel_for(jobs.size(), [&](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            auto g = std::get<1>(jobs[i]);
+            written[i] = write_data_group(target_folder, std::get<0>(jobs[i]), data, *all[g], shifts[g], run_ids, metric, max_points, method);
+        }
+    }, 1);
+
+    //A file that could not be written is generated again the next time
+    for(std::size_t i = 0; i < jobs.size(); ++i){
+        if(written[i]){
+            cache.generated(std::get<0>(jobs[i]), std::move(std::get<2>(jobs[i])));
+        } else {
+            std::cout << "cpm: Failed to write " << std::get<0>(jobs[i]) << std::endl;
+        }
+    }
+
+    std::vector<report_shift> result;
+
+    for(auto& group_shifts : shifts){
+        result.insert(result.end(), group_shifts.begin(), group_shifts.end());
+    }
+
+    return result;
+}
+
+/*
+ * Generate the page listing the shifts of all the benches, the most recent
+ * first. The page depends on all the results, it is always generated.
+ */
+template<typename Theme>
+void generate_regressions_page(const std::string& target_folder, const cpm::reports_data& data, cxxopts::Options& options, std::vector<report_shift> shifts){
+    std::sort(shifts.begin(), shifts.end(), [&data](const report_shift& lhs, const report_shift& rhs){
+        return data.runs[lhs.run].timestamp > data.runs[rhs.run].timestamp;
+    });
+
+    auto& base = data.runs.back();
+
+    cpm::page_buffer stream;
+    cpm::report_page page;
+
+    Theme theme(data, page, options, stream, data.str(base.compiler), data.str(base.configuration));
+
+    header(theme);
+
+    if(options["hctheme"].as<std::string>() == "dark_unica"){
+        theme << "<script>\n" << "\n";
+        theme << dark_unica_theme << "\n";
+        theme << "</script>\n";
+    }
+
+    auto regressions = std::count_if(shifts.begin(), shifts.end(), [](const report_shift& shift){ return shift.regression(); });
+    auto recent = std::count_if(shifts.begin(), shifts.end(), [](const report_shift& shift){ return shift.regression() && shift.recent; });
+
+    theme.before_information("Regressions");
+
+    theme << "<li>Shifts: " << shifts.size() << "</li>\n";
+    theme << "<li>Regressions: " << regressions << "</li>\n";
+    theme << "<li>Recent regressions: " << recent << "</li>\n";
+    theme << "<li>Threshold: " << options["regression-threshold"].as<double>() << "%</li>\n";
+
+    theme.after_information();
+    theme.after_buttons();
+
+    theme.before_regressions();
+
+    theme << "<tr>\n";
+    theme << "<th>Compiler</th>\n";
+    theme << "<th>Configuration</th>\n";
+    theme << "<th>Bench</th>\n";
+    theme << "<th>Tag</th>\n";
+    theme << "<th>Time</th>\n";
+    theme << "<th>Before</th>\n";
+    theme << "<th>After</th>\n";
+    theme << "<th>Change</th>\n";
+    theme << "</tr>\n";
+
+    for(auto& shift : shifts){
+        auto& run = data.runs[shift.run];
+        auto& name = data.str(shift.name);
+
+        std::string href;
+        if(options.count("pages")){
+            href = cpm::filify(data.str(run.compiler), data.str(run.configuration), (shift.section ? "section_" : "bench_") + name);
+        } else {
+            href = cpm::filify(data.str(run.compiler), data.str(run.configuration)) + "#" + result_anchor(shift.section, name);
+        }
+
+        theme << "<tr>\n";
+        theme.cell(data.str(run.compiler));
+        theme.cell(data.str(run.configuration));
+        theme.cell("<a href=\"" + href + "\">" + name + (shift.section ? " / " + data.str(shift.impl) : std::string()) + "</a>");
+        theme.cell(data.str(run.tag));
+        theme.cell(data.str(run.time));
+        theme.cell(cpm::duration_str(shift.before));
+        theme.cell(cpm::duration_str(shift.after));
+
+        auto change = 100.0 * (shift.after - shift.before) / shift.before;
+
+        if(shift.regression()){
+            theme.red_cell("+" + std::to_string(change) + "%" + (shift.recent ? " (recent)" : ""));
+        } else {
+            theme.green_cell(std::to_string(change) + "%");
+        }
+
+        theme << "</tr>\n";
+    }
+
+    theme.after_regressions();
+
+    footer(theme);
+
+    stream.write(target_folder + "/regressions.html");
+}
+
+//Page to generate
+struct page_job {
+    std::string file;
+    const cpm::report_run* run;
+    bool one;
+    bool section;
+    std::string filter;
+    cpm::cache_page entry;
+};
+
+template<typename Theme>
+void generate_pages(const std::string& target_folder, cpm::reports_data& data, cxxopts::Options& options, cpm::report_cache& cache, const cpm::report_changes& changes, const std::vector<report_shift>& shifts){
+    //Select the base run
+    auto& base = data.runs.back();
+
+    std::set<std::string> pages;
+
+    auto report = report_signature(data, options);
+
+    std::vector<page_job> jobs;
+
+    //Generate the page only if its results or its inputs changed
+    auto page = [&](const std::string& file, const cpm::report_run& d, bool one, bool section, const std::string& filter){
+        cpm::cache_page entry{data.str(d.compiler), data.str(d.configuration), one ? filter : std::string(), page_signature(data, report, d, one, section, filter)};
+
+        if(cache.dirty(file, entry, changes, target_folder)){
+            jobs.push_back({file, &d, one, section, filter, std::move(entry)});
+        } else {
+            cache.generated(file, std::move(entry));
+        }
+    };
+
+    if(options.count("pages")){
+        //Generate pages for each (bench-section)/configuration/compiler
+        std::for_each(data.runs.rbegin(), data.runs.rend(), [&](const cpm::report_run& d){
+            for(const auto& result : data.results(d)){
+                auto& title = data.str(result.title);
+                auto file = cpm::filify(data.str(d.compiler), data.str(d.configuration), std::string("bench_") + title);
+                if(!pages.count(file)){
+                    page(file, d, true, false, title);
+
+                    if(pages.empty()){
+                        page("index.html", d, true, false, title);
+                    }
+
+                    pages.insert(file);
+                }
+            }
+
+            for(const auto& section : data.run_sections(d)){
+                auto& name = data.str(section.name);
+                auto file = cpm::filify(data.str(d.compiler), data.str(d.configuration), std::string("section_") + name);
+                if(!pages.count(file)){
+                    page(file, d, true, true, name);
+
+                    if(pages.empty()){
+                        page("index.html", d, true, true, name);
+                    }
+
+                    pages.insert(file);
+                }
+            }
+        });
+    } else {
+        //Generate the index
+        page("index.html", base, false, false, "");
+
+        //Generate the compiler pages
+        std::for_each(data.runs.rbegin(), data.runs.rend(), [&](const cpm::report_run& d){
+            auto file = cpm::filify(data.str(d.compiler), data.str(d.configuration));
+            if(!pages.count(file)){
+                page(file, d, false, false, "");
+                pages.insert(file);
+            }
+        });
+    }
+
+    std::vector<char> written(jobs.size());
+
+    //The pages only share the report data, which is not modified anymore
+    cpm::parallel_for(jobs.size(), [&](std::size_t first, std::size_t last){
+        for(std::size_t i = first; i < last; ++i){
+            auto& job = jobs[i];
+            written[i] = generate_standard_page<Theme>(target_folder, job.file, data, *job.run, select_runs(data, *job.run), options, job.one, job.section, job.filter);
+        }
+    }, 1);
+
+    //A page that could not be written is generated again the next time
+    for(std::size_t i = 0; i < jobs.size(); ++i){
+        if(written[i]){
+            cache.generated(jobs[i].file, std::move(jobs[i].entry));
+        } else {
+            std::cout << "cpm: Failed to write " << jobs[i].file << std::endl;
+        }
+    }
+
+    generate_regressions_page<Theme>(target_folder, data, options, shifts);
+}
+
+//Add the points of a series to the columns of the report
+void add_points(cpm::reports_data& data, const rapidjson::Value& values){
+    auto& series = data.series.back();
+
+    for(auto& r : values){
+        data.sizes.push_back(data.strings.intern(json_string(r["size"])));
+        data.regimes.push_back(r.HasMember("regime") ? data.strings.intern(r["regime"].GetString()) : cpm::no_string);
+
+        data.metrics[cpm::METRIC_MEAN].push_back(json_number(r, "mean"));
+        data.metrics[cpm::METRIC_MEAN_LB].push_back(json_number(r, "mean_lb"));
+        data.metrics[cpm::METRIC_MEAN_UB].push_back(json_number(r, "mean_ub"));
+        data.metrics[cpm::METRIC_STDDEV].push_back(json_number(r, "stddev"));
+        data.metrics[cpm::METRIC_MIN].push_back(json_number(r, "min"));
+        data.metrics[cpm::METRIC_MAX].push_back(json_number(r, "max"));
+        data.metrics[cpm::METRIC_THROUGHPUT_E].push_back(r.HasMember("throughput_e") ? json_number(r, "throughput_e") : json_number(r, "throughput"));
+        data.metrics[cpm::METRIC_THROUGHPUT_F].push_back(json_number(r, "throughput_f"));
+
+        ++series.count;
+    }
+}
+
+//Convert a document to a run of the report, the titles and the names are stored without their tags
+void add_run(cpm::reports_data& data, const cpm::document_t& doc){
+    cpm::report_run run;
+
+    run.name          = data.strings.intern(doc["name"].GetString());
+    run.tag           = data.strings.intern(doc["tag"].GetString());
+    run.compiler      = data.strings.intern(doc["compiler"].GetString());
+    run.configuration = data.strings.intern(doc["configuration"].GetString());
+    run.os            = data.strings.intern(doc["os"].GetString());
+    run.time          = data.strings.intern(doc["time"].GetString());
+    run.timestamp     = doc["timestamp"].GetInt64();
+
+    run.first_result = data.series.size();
+    run.results = 0;
+
+    for(auto& r : doc["results"]){
+        data.series.push_back({data.strings.intern(strip_tags(r["title"].GetString())), static_cast<std::uint32_t>(data.sizes.size()), 0});
+        add_points(data, r["results"]);
+        ++run.results;
+    }
+
+    run.first_section = data.sections.size();
+    run.sections = 0;
+
+    if(doc.HasMember("sections")){
+        for(auto& section : doc["sections"]){
+            data.sections.push_back({data.strings.intern(strip_tags(section["name"].GetString())), static_cast<std::uint32_t>(data.series.size()), 0});
+
+            for(auto& implementation : section["results"]){
+                data.series.push_back({data.strings.intern(strip_tags(implementation["name"].GetString())), static_cast<std::uint32_t>(data.sizes.size()), 0});
+                add_points(data, implementation["results"]);
+                ++data.sections.back().count;
+            }
+
+            ++run.sections;
+        }
+    }
+
+    data.runs.push_back(run);
+}
+
+//Convert a binary result to a run of the report, the metrics are copied
+//from the columns of the mapping and each string is interned once
+void add_run(cpm::reports_data& data, const cpm::binary_file& file){
+    auto& header = file.header();
+
+    std::vector<std::uint32_t> ids(header.n_strings, cpm::no_string);
+
+    auto intern = [&](std::uint32_t id){
+        if(id == cpm::binary_none){
+            return cpm::no_string;
+        }
+
+        if(ids[id] == cpm::no_string){
+            ids[id] = data.strings.intern(std::string(file.string(id), file.length(id)));
+        }
+
+        return ids[id];
+    };
+
+    auto title = [&](std::uint32_t id){
+        return data.strings.intern(strip_tags(file.string(id)));
+    };
+
+    auto points = [&](const cpm::binary_series& series){
+        data.series.back().count = series.count;
+
+        for(std::size_t i = series.first; i < series.first + series.count; ++i){
+            data.sizes.push_back(intern(file.sizes()[i]));
+            data.regimes.push_back(intern(file.regimes()[i]));
+        }
+
+        //The metrics of the report are the first metrics of the binary results
+        for(std::size_t m = 0; m < cpm::METRICS; ++m){
+            auto column = file.metric(static_cast<cpm::binary_metric>(m));
+            data.metrics[m].insert(data.metrics[m].end(), column + series.first, column + series.first + series.count);
+        }
+    };
+
+    cpm::report_run run;
+
+    run.name          = intern(header.name);
+    run.tag           = intern(header.tag);
+    run.compiler      = intern(header.compiler);
+    run.configuration = intern(header.configuration);
+    run.os            = intern(header.os);
+    run.time          = intern(header.time);
+    run.timestamp     = header.timestamp;
+
+    run.first_result = data.series.size();
+    run.results = 0;
+
+    for(std::size_t i = 0; i < header.n_series; ++i){
+        auto& series = file.series()[i];
+
+        if(series.section == cpm::binary_none){
+            data.series.push_back({title(series.title), static_cast<std::uint32_t>(data.sizes.size()), 0});
+            points(series);
+            ++run.results;
+        }
+    }
+
+    run.first_section = data.sections.size();
+    run.sections = 0;
+
+    for(std::size_t i = 0; i < header.n_series; ++i){
+        auto& series = file.series()[i];
+
+        if(series.section == cpm::binary_none){
+            continue;
+        }
+
+        //The implementations of a section are consecutive
+        if(!i || file.series()[i - 1].section != series.section){
+            data.sections.push_back({title(series.section), static_cast<std::uint32_t>(data.series.size()), 0});
+            ++run.sections;
+        }
+
+        data.series.push_back({title(series.title), static_cast<std::uint32_t>(data.sizes.size()), 0});
+        points(series);
+        ++data.sections.back().count;
+    }
+
+    data.runs.push_back(run);
+}
+
+//Write the document in the binary format for .cpmb files and in JSON otherwise
+bool write_document(const cpm::document_t& doc, const std::string& path){
+    if(ends_with(path, ".cpmb")){
+        return write_binary_document(doc, path);
+    }
+
+    rapidjson::StringBuffer buffer;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+    doc.Accept(writer);
+
+    std::ofstream stream(path);
+    stream << buffer.GetString();
+
+    return static_cast<bool>(stream);
+}
+
+//Merge the result files of the shards of a run into a single result file
+int merge(int argc, char* argv[]){
+    if(argc < 4){
+        std::cout << "Usage: cpm merge output.cpm shard.cpm..." << std::endl;
+        return -1;
+    }
+
+    std::string output = argv[2];
+
+    std::vector<cpm::document_t> shards;
+
+    for(int i = 3; i < argc; ++i){
+        auto doc = read_document(argv[i]);
+
+        if(doc.HasParseError()){
+            std::cout << "cpm: Impossible to read document " << argv[i] << ", parse error: " << rapidjson::GetParseError_En(doc.GetParseError()) << std::endl;
+            return -1;
+        }
+
+        shards.push_back(std::move(doc));
+    }
+
+    //The merged run starts with its first shard
+    std::stable_sort(shards.begin(), shards.end(),
+        [](const cpm::document_t& lhs, const cpm::document_t& rhs){ return lhs["timestamp"].GetInt() < rhs["timestamp"].GetInt(); });
+
+    auto& base = shards.front();
+
+    for(auto& shard : shards){
+        for(auto key : {"name", "compiler", "configuration"}){
+            if(!str_equal(shard[key].GetString(), base[key].GetString())){
+                std::cout << "cpm: The shards have different " << key << " (" << base[key].GetString() << ", " << shard[key].GetString() << "), exiting" << std::endl;
+                return -1;
+            }
+        }
+
+        for(auto key : {"tag", "os"}){
+            if(!str_equal(shard[key].GetString(), base[key].GetString())){
+                std::cout << "cpm: Warning: The shards have different " << key << ", keeping " << base[key].GetString() << std::endl;
+            }
+        }
+    }
 
-    y_axis_configuration(theme);
+    cpm::document_t merged;
+    auto& allocator = merged.GetAllocator();
 
-    theme << "legend: { align: 'left', verticalAlign: 'top', floating: false, borderWidth: 0, y: 20 },\n";
+    merged.CopyFrom(base, allocator);
 
-    theme << "series: [\n";
+    if(merged.HasMember("shard")){
+        merged.RemoveMember("shard");
+    }
 
-    std::string comma = "";
-    for(auto& r : section["results"]){
-        theme << comma << "{\n";
+    std::set<std::string> titles;
+    std::set<std::string> names;
 
-        theme << "name: '" << strip_tags(r["name"].GetString()) << "',\n";
-        theme << "data: [";
+    for(auto& r : base["results"]){
+        titles.insert(strip_tags(r["title"].GetString()));
+    }
 
-        std::string comma_inner = "";
+    if(base.HasMember("sections")){
+        for(auto& section : base["sections"]){
+            names.insert(strip_tags(section["name"].GetString()));
+        }
+    } else {
+        rapidjson::Value sections(rapidjson::kArrayType);
+        merged.AddMember("sections", sections, allocator);
+    }
 
-        for(auto& r_doc_r : documents){
-            auto& r_doc = static_cast<const cpm::document_t&>(r_doc_r);
+    for(std::size_t i = 1; i < shards.size(); ++i){
+        for(auto& r : shards[i]["results"]){
+            if(titles.insert(strip_tags(r["title"].GetString())).second){
+                merged["results"].PushBack(rapidjson::Value(r, allocator), allocator);
+            } else {
+                std::cout << "cpm: Warning: " << r["title"].GetString() << " is in several shards, keeping the first" << std::endl;
+            }
+        }
 
-            for(auto& r_section : r_doc["sections"]){
-                if(strip_equal(r_section["name"].GetString(), section["name"].GetString())){
-                    for(auto& r_r : r_section["results"]){
-                        if(strip_equal(r_r["name"].GetString(), r["name"].GetString())){
-                            theme << comma_inner << "[" << size_t(r_doc["timestamp"].GetInt()) * 1000 << ",";
-                            auto& r_r_results = r_r["results"];
-                            theme << r_r_results[r_r_results.Size() - 1][value_key_name(theme)].GetDouble() << "]";
-                            comma_inner = ",";
-                        }
-                    }
+        if(shards[i].HasMember("sections")){
+            for(auto& section : shards[i]["sections"]){
+                if(names.insert(strip_tags(section["name"].GetString())).second){
+                    merged["sections"].PushBack(rapidjson::Value(section, allocator), allocator);
+                } else {
+                    std::cout << "cpm: Warning: " << section["name"].GetString() << " is in several shards, keeping the first" << std::endl;
                 }
             }
         }
+    }
 
-        theme << "]\n";
-        theme << "}\n";
-        comma = ",";
+    if(!write_document(merged, output)){
+        std::cout << "cpm: Impossible to write " << output << std::endl;
+        return -1;
     }
 
-    theme << "]\n";
+    std::cout << "Merged " << shards.size() << " shards into " << output << std::endl;
 
-    end_graph(theme);
-    theme.after_graph();
-    ++id;
+    return 0;
 }
 
-template<typename Theme, typename Filter>
-void generate_section_compare_graph(Theme& theme, std::size_t& id, const rapidjson::Value& section, const std::string& title, const char* attr, Filter f){
-    std::size_t sub_id = 0;
-
-    theme.before_sub_graphs(id, string_collect(section["results"], "name"));
+//Convert a result file between the JSON and the binary formats
+int convert(int argc, char* argv[]){
+    if(argc != 4){
+        std::cout << "Usage: cpm convert input.cpm[b] output.cpm[b]" << std::endl;
+        return -1;
+    }
 
-    for(auto& r : section["results"]){
-        theme.before_sub_graph(id, sub_id++);
+    auto doc = read_document(argv[2]);
 
-        start_graph(theme,
-            std::string("chart_") + std::to_string(id) + "-" + std::to_string(sub_id - 1),
-            title + strip_tags(section["name"].GetString()) + "-" + strip_tags(r["name"].GetString()));
+    if(doc.HasParseError()){
+        std::cout << "cpm: Impossible to read document " << argv[2] << ", parse error: " << rapidjson::GetParseError_En(doc.GetParseError()) << std::endl;
+        return -1;
+    }
 
-        theme << "xAxis: { categories: \n";
+    if(!write_document(doc, argv[3])){
+        std::cout << "cpm: Impossible to write " << argv[3] << std::endl;
+        return -1;
+    }
 
-        auto sizes = gather_sizes(section);
+    return 0;
+}
 
-        json_array_string(theme, sizes);
+//Field of a CSV line, quoted if needed
+std::string csv_field(const std::string& value){
+    if(value.find_first_of(",\"\r\n") == std::string::npos){
+        return value;
+    }
 
-        theme << "},\n";
+    std::string quoted = "\"";
 
-        y_axis_configuration(theme);
+    for(char c : value){
+        quoted += c;
 
-        theme << "legend: { align: 'left', verticalAlign: 'top', floating: false, borderWidth: 0, y: 20 },\n";
+        if(c == '"'){
+            quoted += '"';
+        }
+    }
 
-        theme << "series: [\n";
+    return quoted + "\"";
+}
 
-        std::string comma = "";
-        for(auto& document : theme.data.documents){
-            if(f(document)){
-                for(auto& o_section : document["sections"]){
-                    if(strip_equal(o_section["name"].GetString(), section["name"].GetString())){
-                        for(auto& o_r : o_section["results"]){
-                            if(strip_equal(o_r["name"].GetString(), r["name"].GetString())){
-                                theme << comma << "{\n";
-                                theme << "name: '" << document[attr].GetString() << "',\n";
-                                theme << "data: ";
+//Extract the series of benches from the results store of a folder
+int query(int argc, char* argv[]){
+    cxxopts::Options options("cpm query", "results_folder");
 
-                                json_array_value(theme, double_collect(o_r["results"], value_key_name(theme)));
+    try {
+        options.add_options()
+            ("b,bench", "Bench title or section name (all by default)", cxxopts::value<std::string>())
+            ("s,size", "Size (all by default)", cxxopts::value<std::string>())
+            ("days", "Only the runs of the last days", cxxopts::value<std::size_t>())
+            ("n,name", "Benchmark name", cxxopts::value<std::string>())
+            ("compiler", "Compiler", cxxopts::value<std::string>())
+            ("configuration", "Configuration", cxxopts::value<std::string>())
+            ("t,tag", "Tag", cxxopts::value<std::string>())
+            ("input", "Results folder", cxxopts::value<std::string>())
+            ("h,help", "Print help")
+            ;
 
-                                theme << "\n}\n";
+        options.parse_positional("input");
+        options.parse(argc, argv);
 
-                                comma = ",";
-                            }
-                        }
-                    }
-                }
-            }
+        if (options.count("help") || !options.count("input")){
+            std::cout << options.help({""}) << std::endl;
+            return options.count("help") ? 0 : -1;
         }
+    } catch (const cxxopts::OptionException& e){
+        std::cout << "cpm: error parsing options: " << e.what() << std::endl;
+        return -1;
+    }
 
-        theme << "]\n";
-
-        end_graph(theme);
+    cpm::results_store store(options["input"].as<std::string>());
 
-        theme.after_sub_graph();
+    if(!store.exists()){
+        std::cout << "cpm: No results store in " << options["input"].as<std::string>() << std::endl;
+        return -1;
     }
 
-    theme.after_sub_graphs();
+    std::int64_t since = 0;
+    if(options.count("days")){
+        since = std::chrono::duration_cast<cpm::seconds>(cpm::wall_clock::now().time_since_epoch()).count() - std::int64_t(options["days"].as<std::size_t>()) * 24 * 3600;
+    }
 
-    ++id;
-}
+    auto key_match = [&options](const char* key, const std::string& value){
+        return !options.count(key) || options[key].as<std::string>() == value;
+    };
 
-template<typename Theme>
-void generate_section_compiler_graph(Theme& theme, std::size_t& id, const rapidjson::Value& section, const cpm::document_t& base){
-    generate_section_compare_graph(theme, id, section, "Compiler:", "compiler", compiler_filter(base));
-}
+    auto bench = options.count("bench") ? strip_tags(options["bench"].as<std::string>()) : std::string();
 
-template<typename Theme>
-void generate_section_configuration_graph(Theme& theme, std::size_t& id, const rapidjson::Value& section, const cpm::document_t& base){
-    generate_section_compare_graph(theme, id, section, "Configuration:", "configuration", configuration_filter(base));
-}
+    //Only the selected runs are touched in the mapped store
+    auto index = store.index();
 
-template<typename Theme>
-std::pair<bool, double> find_same_duration_section(Theme& theme, json_value base_result, json_value base_section, json_value r, const cpm::document_t& doc){
-    for(auto& section : doc["sections"]){
-        if(strip_equal(section["name"].GetString(), base_section["name"].GetString())){
-            for(auto& result : section["results"]){
-                if(strip_equal(result["name"].GetString(), base_result["name"].GetString())){
-                    for(auto& p_r_r : result["results"]){
-                        if(str_equal(p_r_r["size"].GetString(), r["size"].GetString())){
-                            return std::make_pair(true, p_r_r[value_key_name(theme)].GetDouble());
-                        }
-                    }
-                }
-            }
-        }
+    cpm::file_mapping mapping;
+    if(!index.empty() && !mapping.open(store.data_file())){
+        std::cout << "cpm: Impossible to map " << store.data_file() << std::endl;
+        return -1;
     }
 
-    return std::make_pair(false, 0.0);
-}
-
-template<typename Theme>
-std::pair<bool,double> compare_section(Theme& theme, json_value base_result, json_value base_section, json_value r, const cpm::document_t& doc){
-    bool found;
-    int previous;
-    std::tie(found, previous) = find_same_duration_section(theme, base_result, base_section, r, doc);
+    std::cout << "timestamp,tag,compiler,configuration,bench,size,mean,stddev,min,max,throughput_e,throughput_f" << std::endl;
 
-    if(found){
-        auto current = r[value_key_name(theme)].GetDouble();
+    for(auto& entry : index){
+        if(entry.timestamp < since || !key_match("name", entry.name) || !key_match("compiler", entry.compiler)
+                || !key_match("configuration", entry.configuration) || !key_match("tag", entry.tag)){
+            continue;
+        }
 
-        double diff = add_compare_cell(theme, current, previous);
-        return std::make_pair(true, diff);
-    }
+        cpm::binary_file file;
+        if(!cpm::results_store::record(mapping, entry, file)){
+            continue;
+        }
 
-    return std::make_pair(false, 0.0);
-}
+        for(std::size_t i = 0; i < file.header().n_series; ++i){
+            auto& series = file.series()[i];
 
-template<typename Theme>
-void generate_section_summary_table(Theme& theme, std::size_t id, json_value base_section, const cpm::document_t& base){
-    std::size_t sub_id = 0;
-    theme.before_sub_graphs(id * 1000000, string_collect(base_section["results"], "name"));
+            std::string title = file.string(series.section == cpm::binary_none ? series.title : series.section);
 
-    auto flops = theme.options.count("mflops");
+            if(!bench.empty() && strip_tags(title) != bench){
+                continue;
+            }
 
-    for(auto& base_result : base_section["results"]){
-        theme.before_sub_summary(id * 1000000, sub_id++);
+            if(series.section != cpm::binary_none){
+                title += "/";
+                title += file.string(series.title);
+            }
 
-        summary_header(theme);
+            for(std::size_t j = series.first; j < series.first + series.count; ++j){
+                if(!key_match("size", file.string(file.sizes()[j]))){
+                    continue;
+                }
 
-        double previous_acc = 0;
-        double first_acc = 0;
+                std::cout
+                    << entry.timestamp << "," << csv_field(entry.tag) << "," << csv_field(entry.compiler) << "," << csv_field(entry.configuration) << ","
+                    << csv_field(title) << "," << csv_field(file.string(file.sizes()[j])) << ","
+                    << file.metric(cpm::BINARY_MEAN)[j] << "," << file.metric(cpm::BINARY_STDDEV)[j] << ","
+                    << file.metric(cpm::BINARY_MIN)[j] << "," << file.metric(cpm::BINARY_MAX)[j] << ","
+                    << file.metric(cpm::BINARY_THROUGHPUT_E)[j] << "," << file.metric(cpm::BINARY_THROUGHPUT_F)[j] << std::endl;
+            }
+        }
+    }
 
-        for(auto& r : base_result["results"]){
-            theme << "<tr>\n";
-            theme << "<td>" << r["size"].GetString() << "</td>\n";
-            theme << "<td>" << r["mean"].GetDouble() << "</td>\n";
+    return 0;
+}
 
-            if(flops){
-                theme << "<td>" << cpm::throughput_str(r["throughput_f"].GetDouble()) << "</td>\n";
-            } else {
-                theme << "<td>" << cpm::throughput_str(r["throughput_e"].GetDouble()) << "</td>\n";
-            }
+//Point of a run to compare
+struct compare_point {
+    double mean;
+    double stddev;
+    double n;                    //Number of samples
+    std::vector<double> samples; //Raw samples, if they were recorded
+};
+
+//The points of a run, by bench (or section/implementation) and size
+using compare_points = std::map<std::pair<std::string, std::string>, compare_point>;
+
+//Number of samples behind a mean, recovered from its 95% confidence interval
+double sample_count(double mean, double mean_ub, double stddev){
+    if(mean_ub <= mean || stddev <= 0.0){
+        return 2.0;
+    }
 
-            bool previous_found = false;
-            double diff = 0.0;
+    return std::max(2.0, std::round((1.96 * stddev / (mean_ub - mean)) * (1.96 * stddev / (mean_ub - mean))));
+}
 
-            auto documents = select_documents(theme.data.documents, base);
+void add_compare_points(compare_points& points, const std::string& bench, const rapidjson::Value& values){
+    for(auto& r : values){
+        auto& point = points[std::make_pair(bench, json_string(r["size"]))];
 
-            for(std::size_t i = 0; i < documents.size() - 1; ++i){
-                if(&static_cast<const cpm::document_t&>(documents[i+1]) == &base){
-                    auto& doc = static_cast<const cpm::document_t&>(documents[i]);
-                    std::tie(previous_found, diff) = compare_section(theme, base_result, base_section, r, doc);
+        point.mean = json_number(r, "mean");
+        point.stddev = json_number(r, "stddev");
+        point.n = sample_count(point.mean, json_number(r, "mean_ub"), point.stddev);
 
-                    if(previous_found){
-                        previous_acc += diff;
-                        break;
-                    }
-                }
+        if(r.HasMember("samples") && r["samples"].IsArray()){
+            for(auto& sample : r["samples"]){
+                point.samples.push_back(sample.GetDouble());
             }
+        }
+
+        //A repeated run is compared on the means of its processes, a difference must survive the layout changes
+        if(r.HasMember("repetitions") && r["repetitions"].IsArray() && r["repetitions"].Size() > 1){
+            auto& repetitions = r["repetitions"];
 
-            if(!previous_found){
-                theme << "<td>N/A</td>\n";
+            double variance = 0.0;
+            for(auto& repetition : repetitions){
+                variance += (json_number(repetition, "mean") - point.mean) * (json_number(repetition, "mean") - point.mean);
             }
 
-            previous_found = false;
+            point.stddev = std::sqrt(variance / (repetitions.Size() - 1));
+            point.n = repetitions.Size();
+            point.samples.clear();
+        }
+    }
+}
 
-            if(documents.size() > 1){
-                auto& doc = static_cast<const cpm::document_t&>(documents[0]);
-                std::tie(previous_found, diff) = compare_section(theme, base_result, base_section, r, doc);
+compare_points collect_compare_points(const cpm::document_t& doc){
+    compare_points points;
 
-                first_acc += diff;
-            }
+    for(auto& r : doc["results"]){
+        add_compare_points(points, strip_tags(r["title"].GetString()), r["results"]);
+    }
 
-            if(!previous_found){
-                theme << "<td>N/A</td>\n";
+    if(doc.HasMember("sections")){
+        for(auto& section : doc["sections"]){
+            for(auto& implementation : section["results"]){
+                add_compare_points(points, strip_tags(section["name"].GetString()) + "/" + strip_tags(implementation["name"].GetString()), implementation["results"]);
             }
+        }
+    }
 
-            if(theme.data.compilers.size() > 1){
-                std::string best_compiler = base["compiler"].GetString();
-                auto best = r[value_key_name(theme)].GetDouble();
-                auto worst = r[value_key_name(theme)].GetDouble();
-
-                for(auto& doc : theme.data.documents){
-                    if(is_compiler_relevant(base, doc)){
-                        bool found;
-                        int duration;
-                        std::tie(found, duration) = find_same_duration_section(theme, base_result, base_section, r, doc);
-
-                        if(found){
-                            if(flops){
-                                if(duration > best){
-                                    best = duration;
-                                    best_compiler = doc["compiler"].GetString();
-                                } else if(duration < worst){
-                                    worst = duration;
-                                }
-                            } else {
-                                if(duration < best){
-                                    best = duration;
-                                    best_compiler = doc["compiler"].GetString();
-                                } else if(duration > worst){
-                                    worst = duration;
-                                }
-                            }
-                        }
-                    }
-                }
+    return points;
+}
 
-                theme.cell(best_compiler);
+//Read a run to compare, a result file or the latest run of a tag in the results folder
+cpm::document_t compare_document(const std::string& input, cxxopts::Options& options){
+    struct stat buffer;
+    if(stat(input.c_str(), &buffer) == 0 && S_ISREG(buffer.st_mode)){
+        return read_document(input);
+    }
 
-                auto max_diff = std::abs(100.0 * (static_cast<double>(worst) / best) - 100.0);
+    auto folder = options["folder"].as<std::string>();
 
-                theme.cell(std::to_string(max_diff) + "%");
-            }
+    auto key_match = [&options](const char* key, const std::string& value){
+        return !options.count(key) || options[key].as<std::string>() == value;
+    };
 
-            if(theme.data.configurations.size() > 1){
-                std::string best_configuration = base["configuration"].GetString();
-                auto best = r[value_key_name(theme)].GetDouble();
-                auto worst = r[value_key_name(theme)].GetDouble();
-
-                for(auto& doc : theme.data.documents){
-                    if(is_configuration_relevant(base, doc)){
-                        bool found;
-                        int duration;
-                        std::tie(found, duration) = find_same_duration_section(theme, base_result, base_section, r, doc);
-
-                        if(found){
-                            if(flops){
-                                if(duration > best){
-                                    best = duration;
-                                    best_configuration = doc["configuration"].GetString();
-                                } else if(duration < worst){
-                                    worst = duration;
-                                }
-                            } else {
-                                if(duration < best){
-                                    best = duration;
-                                    best_configuration = doc["configuration"].GetString();
-                                } else if(duration > worst){
-                                    worst = duration;
-                                }
-                            }
-                        }
-                    }
-                }
+    auto documents = read_store(folder, [&](const cpm::store_entry& entry){
+        return entry.tag == input && key_match("compiler", entry.compiler) && key_match("configuration", entry.configuration);
+    });
 
-                theme.cell(best_configuration);
+    struct dirent* entry;
+    DIR* dp = opendir(folder.c_str());
 
-                auto max_diff = std::abs(100.0 * (static_cast<double>(worst) / best) - 100.0);
+    while(dp && (entry = readdir(dp))){
+        if(entry->d_type == DT_REG && is_result_file(entry->d_name)){
+            auto doc = read_document(folder + "/" + entry->d_name);
 
-                theme.cell(std::to_string(max_diff) + "%");
+            if(!doc.HasParseError() && input == doc["tag"].GetString()
+                    && key_match("compiler", doc["compiler"].GetString()) && key_match("configuration", doc["configuration"].GetString())){
+                documents.push_back(std::move(doc));
             }
-
-            theme << "</tr>\n";
         }
+    }
 
-        previous_acc /= base_result["results"].Size();
-        first_acc /= base_result["results"].Size();
+    if(dp){
+        closedir(dp);
+    }
 
-        summary_footer(theme, previous_acc, first_acc);
+    cpm::document_t latest;
 
-        theme.after_sub_summary();
+    if(documents.empty()){
+        latest.Parse("");
+        return latest;
     }
 
-    theme.after_sub_graphs();
+    auto it = std::max_element(documents.begin(), documents.end(),
+        [](const cpm::document_t& lhs, const cpm::document_t& rhs){ return lhs["timestamp"].GetInt64() < rhs["timestamp"].GetInt64(); });
+
+    return std::move(*it);
 }
 
-template<typename Theme>
-void generate_standard_page(const std::string& target_folder, const std::string& file, cpm::reports_data& data, const cpm::document_t& doc, const std::vector<cpm::document_cref>& documents, cxxopts::Options& options, bool one = false, bool section = false, const std::string& filter = ""){
-    bool time_graphs = !options.count("disable-time") && documents.size() > 1;
-    bool compiler_graphs = !options.count("disable-compiler") && data.compilers.size() > 1;
-    bool configuration_graphs = !options.count("disable-configuration") && data.configurations.size() > 1;
-    bool summary_table = !options.count("disable-summary");
+//Comparison of a point of the two runs
+struct comparison {
+    std::string bench;
+    std::string size;
+    double old_mean;
+    double new_mean;
+    double ratio;      //new / old, larger than 1 if slower
+    double ci_low;
+    double ci_high;
+    const char* test;
+    double p_value;
+    double p_adjusted;
+    const char* verdict;
+};
+
+std::string percent_str(double ratio){
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%+.2f%%", 100.0 * (ratio - 1.0));
+    return buffer;
+}
 
-    std::string target_file = target_folder + "/" + file;
+std::string p_str(double p){
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), p < 0.0001 ? "%.1e" : "%.4f", p);
+    return buffer;
+}
 
-    std::ofstream stream(target_file);
+int compare_runs(int argc, char* argv[]){
+    cxxopts::Options options("cpm compare", "old new (result files or tags)");
 
-    Theme theme(data, options, stream, doc["compiler"].GetString(), doc["configuration"].GetString());
+    try {
+        options.add_options()
+            ("i,folder", "Results folder of the tags", cxxopts::value<std::string>()->default_value("."), "folder")
+            ("compiler", "Compiler of the tags", cxxopts::value<std::string>())
+            ("configuration", "Configuration of the tags", cxxopts::value<std::string>())
+            ("f,format", "Output format [terminal,markdown,json]", cxxopts::value<std::string>()->default_value("terminal"), "format")
+            ("t,threshold", "Slowdown making a significant difference a regression, in percent", cxxopts::value<double>()->default_value("5"), "percent")
+            ("a,alpha", "Significance level", cxxopts::value<double>()->default_value("0.05"))
+            ("correction", "Correction for multiple comparisons [bh,holm,none]", cxxopts::value<std::string>()->default_value("bh"))
+            ("inputs", "The old and the new runs", cxxopts::value<std::vector<std::string>>())
+            ("h,help", "Print help")
+            ;
 
-    //Header of the page
-    header(theme);
+        options.parse_positional("inputs");
+        options.parse(argc, argv);
 
-    //Configure the highcharts theme
-    if(options["hctheme"].as<std::string>() == "dark_unica"){
-        theme << "<script>\n" << "\n";
-        theme << dark_unica_theme << "\n";
-        theme << "</script>\n";
+        if (options.count("help") || options.count("inputs") != 2){
+            std::cout << options.help({""}) << std::endl;
+            return options.count("help") ? 0 : -1;
+        }
+    } catch (const cxxopts::OptionException& e){
+        std::cout << "cpm: error parsing options: " << e.what() << std::endl;
+        return -1;
     }
 
-    if(one){
-        data.file = file;
-
-        if(section){
-            data.sub_part = std::string("section_") + filter;
-        } else {
-            data.sub_part = std::string("bench_") + filter;
-        }
+    auto& inputs = options["inputs"].as<std::vector<std::string>>();
 
-        data.files.clear();
+    auto old_doc = compare_document(inputs[0], options);
+    auto new_doc = compare_document(inputs[1], options);
 
-        for(const auto& result : doc["results"]){
-            std::string name(strip_tags(result["title"].GetString()));
-            data.files.emplace_back(name, cpm::filify(doc["compiler"].GetString(), doc["configuration"].GetString(), std::string("bench_") + name));
+    for(std::size_t i = 0; i < 2; ++i){
+        if((i ? new_doc : old_doc).HasParseError()){
+            std::cout << "cpm: Impossible to read the run " << inputs[i] << std::endl;
+            return -1;
         }
+    }
+
+    //The runs of different hosts or setups are not comparable
+    if(old_doc.HasMember("environment") && new_doc.HasMember("environment")){
+        for(auto key : {"cpu_model", "governor", "turbo", "smt", "march", "optimized"}){
+            auto& old_env = old_doc["environment"];
+            auto& new_env = new_doc["environment"];
 
-        for(const auto& section : doc["sections"]){
-            std::string name(strip_tags(section["name"].GetString()));
-            data.files.emplace_back(name, cpm::filify(doc["compiler"].GetString(), doc["configuration"].GetString(), std::string("section_") + name));
+            if(old_env.HasMember(key) && new_env.HasMember(key) && json_string(old_env[key]) != json_string(new_env[key])){
+                std::cerr << "cpm: Warning: The runs have different " << key << " (" << json_string(old_env[key]) << ", " << json_string(new_env[key]) << ")" << std::endl;
+            }
         }
     }
 
-    //Information block about the last run
-    information(theme, doc);
+    auto format = options["format"].as<std::string>();
+    auto threshold = options["threshold"].as<double>() / 100.0;
+    auto alpha = options["alpha"].as<double>();
 
-    //Compiler selection
-    compiler_buttons(theme);
+    auto correction = cpm::correction::BENJAMINI_HOCHBERG;
+    if(options["correction"].as<std::string>() == "holm"){
+        correction = cpm::correction::HOLM;
+    } else if(options["correction"].as<std::string>() == "none"){
+        correction = cpm::correction::NONE;
+    }
 
-    //Configuration selection
-    configuration_buttons(theme);
+    auto old_points = collect_compare_points(old_doc);
+    auto new_points = collect_compare_points(new_doc);
 
-    //More informations for some theme (navigation list for instance)
-    after_buttons(theme);
+    std::vector<comparison> comparisons;
+    std::size_t only_old = 0;
+    std::size_t only_new = 0;
 
-    std::size_t id = 1;
+    for(auto& point : old_points){
+        auto it = new_points.find(point.first);
 
-    if(!one || !section){
-        for(const auto& result : doc["results"]){
-            if(!one || filter == strip_tags(result["title"].GetString())){
-                theme.before_result(strip_tags(result["title"].GetString()), false, documents);
+        if(it == new_points.end()){
+            ++only_old;
+            continue;
+        }
 
-                generate_run_graph(theme, id, result);
+        auto& a = point.second;
+        auto& b = it->second;
 
-                if(time_graphs){
-                    generate_time_graph(theme, id, result, documents);
-                }
+        comparison c;
+        c.bench = point.first.first;
+        c.size = point.first.second;
+        c.old_mean = a.mean;
+        c.new_mean = b.mean;
+        c.ratio = a.mean == 0.0 ? 1.0 : b.mean / a.mean;
 
-                if(compiler_graphs){
-                    generate_compiler_graph(theme, id, result, doc);
-                }
+        auto welch = cpm::welch_test(a.mean, a.stddev, a.n, b.mean, b.stddev, b.n);
 
-                if(configuration_graphs){
-                    generate_configuration_graph(theme, id, result, doc);
-                }
+        //The raw samples do not need any assumption on their distribution
+        if(a.samples.size() > 1 && b.samples.size() > 1){
+            c.test = "mann-whitney";
+            c.p_value = cpm::mann_whitney(a.samples, b.samples).p_value;
+        } else {
+            c.test = "welch";
+            c.p_value = welch.p_value;
+        }
 
-                if(summary_table){
-                    generate_summary_table(theme, result, doc);
-                }
+        if(a.mean > 0.0 && b.mean > 0.0){
+            std::tie(c.ci_low, c.ci_high) = cpm::ratio_interval(a.mean, a.stddev / std::sqrt(a.n), b.mean, b.stddev / std::sqrt(b.n), welch.df, 1.0 - alpha);
+        } else {
+            c.ci_low = c.ci_high = c.ratio;
+        }
 
-                theme.after_result();
-            }
+        comparisons.push_back(c);
+    }
+
+    for(auto& point : new_points){
+        if(!old_points.count(point.first)){
+            ++only_new;
         }
     }
 
-    if(!one || section){
-        for(auto& section : doc["sections"]){
-            if(!one || filter == strip_tags(section["name"].GetString())){
-                theme.before_result(strip_tags(section["name"].GetString()), compiler_graphs, documents);
+    std::vector<double> p_values;
+    for(auto& c : comparisons){
+        p_values.push_back(c.p_value);
+    }
 
-                generate_section_run_graph(theme, id, section);
+    auto adjusted = cpm::adjust_p_values(p_values, correction);
 
-                if(time_graphs){
-                    generate_section_time_graph(theme, id, section, documents);
-                }
+    std::size_t faster = 0;
+    std::size_t slower = 0;
+    std::size_t regressions = 0;
 
-                if(compiler_graphs){
-                    generate_section_compiler_graph(theme, id, section, doc);
-                }
+    for(std::size_t i = 0; i < comparisons.size(); ++i){
+        auto& c = comparisons[i];
 
-                if(configuration_graphs){
-                    generate_section_configuration_graph(theme, id, section, doc);
-                }
+        c.p_adjusted = adjusted[i];
 
-                if(summary_table){
-                    generate_section_summary_table(theme, id, section, doc);
-                }
+        if(c.p_adjusted >= alpha){
+            c.verdict = "same";
+        } else if(c.ratio < 1.0){
+            c.verdict = "faster";
+            ++faster;
+        } else if(c.ratio - 1.0 >= threshold){
+            c.verdict = "regression";
+            ++slower;
+            ++regressions;
+        } else {
+            c.verdict = "slower";
+            ++slower;
+        }
+    }
 
-                theme.after_result();
+    if(format == "json"){
+        rapidjson::StringBuffer buffer;
+        rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(buffer);
+
+        auto run = [&writer](const char* key, const cpm::document_t& doc){
+            writer.Key(key);
+            writer.StartObject();
+            for(auto field : {"name", "tag", "compiler", "configuration", "time"}){
+                writer.Key(field);
+                writer.String(doc[field].GetString());
             }
+            writer.EndObject();
+        };
+
+        writer.StartObject();
+
+        run("old", old_doc);
+        run("new", new_doc);
+
+        writer.Key("threshold");
+        writer.Double(threshold);
+        writer.Key("alpha");
+        writer.Double(alpha);
+        writer.Key("correction");
+        writer.String(options["correction"].as<std::string>().c_str());
+
+        writer.Key("comparisons");
+        writer.StartArray();
+
+        for(auto& c : comparisons){
+            writer.StartObject();
+            writer.Key("bench");
+            writer.String(c.bench.c_str());
+            writer.Key("size");
+            writer.String(c.size.c_str());
+            writer.Key("old");
+            writer.Double(c.old_mean);
+            writer.Key("new");
+            writer.Double(c.new_mean);
+            writer.Key("ratio");
+            writer.Double(c.ratio);
+            writer.Key("ci_low");
+            writer.Double(c.ci_low);
+            writer.Key("ci_high");
+            writer.Double(c.ci_high);
+            writer.Key("test");
+            writer.String(c.test);
+            writer.Key("p_value");
+            writer.Double(c.p_value);
+            writer.Key("p_adjusted");
+            writer.Double(c.p_adjusted);
+            writer.Key("verdict");
+            writer.String(c.verdict);
+            writer.EndObject();
         }
-    }
 
-    footer(theme);
-}
+        writer.EndArray();
+
+        writer.Key("faster");
+        writer.Uint64(faster);
+        writer.Key("slower");
+        writer.Uint64(slower);
+        writer.Key("regressions");
+        writer.Uint64(regressions);
+        writer.Key("only_old");
+        writer.Uint64(only_old);
+        writer.Key("only_new");
+        writer.Uint64(only_new);
+
+        writer.EndObject();
+
+        std::cout << buffer.GetString() << std::endl;
+    } else if(format == "markdown"){
+        std::cout << "| Bench | Size | Old | New | Change | " << 100.0 * (1.0 - alpha) << "% CI | p | Verdict |" << std::endl;
+        std::cout << "|---|---|---:|---:|---:|---|---:|---|" << std::endl;
+
+        for(auto& c : comparisons){
+            std::cout
+                << "| " << c.bench << " | " << c.size << " | " << cpm::duration_str(c.old_mean, 4) << " | " << cpm::duration_str(c.new_mean, 4)
+                << " | " << percent_str(c.ratio) << " | [" << percent_str(c.ci_low) << ", " << percent_str(c.ci_high) << "] | " << p_str(c.p_adjusted)
+                << " | " << (std::string(c.verdict) == "regression" ? "**regression**" : c.verdict) << " |" << std::endl;
+        }
 
-template<typename Theme>
-void generate_pages(const std::string& target_folder, cpm::reports_data& data, cxxopts::Options& options){
-    //Select the base document
-    auto& base = data.documents.back();
+        std::cout << std::endl;
+        std::cout << comparisons.size() << " compared, " << faster << " faster, " << slower << " slower, " << regressions << " regressions";
+        std::cout << " (" << only_old << " only in old, " << only_new << " only in new)" << std::endl;
+    } else {
+        std::size_t width = 5;
+        for(auto& c : comparisons){
+            width = std::max(width, c.bench.size() + 1 + c.size.size());
+        }
 
-    std::set<std::string> pages;
+        std::cout << std::left << std::setw(width) << "Bench" << "  " << std::right
+            << std::setw(12) << "Old" << std::setw(12) << "New" << std::setw(10) << "Change" << std::setw(22) << "CI" << std::setw(10) << "p" << "  Verdict" << std::endl;
 
-    if(options.count("pages")){
-        //Generate pages for each (bench-section)/configuration/compiler
-        std::for_each(data.documents.rbegin(), data.documents.rend(), [&](cpm::document_t& d){
-            for(const auto& result : d["results"]){
-                auto file = cpm::filify(d["compiler"].GetString(), d["configuration"].GetString(), std::string("bench_") + strip_tags(result["title"].GetString()));
-                if(!pages.count(file)){
-                    generate_standard_page<Theme>(target_folder, file, data, d, select_documents(data.documents, d), options, true, false, strip_tags(result["title"].GetString()));
+        for(auto& c : comparisons){
+            std::cout << std::left << std::setw(width) << (c.bench + ":" + c.size) << "  " << std::right
+                << std::setw(12) << cpm::duration_str(c.old_mean, 4) << std::setw(12) << cpm::duration_str(c.new_mean, 4)
+                << std::setw(10) << percent_str(c.ratio) << std::setw(22) << ("[" + percent_str(c.ci_low) + ", " + percent_str(c.ci_high) + "]")
+                << std::setw(10) << p_str(c.p_adjusted) << "  " << c.verdict << std::endl;
+        }
 
-                    if(pages.empty()){
-                        generate_standard_page<Theme>(target_folder, "index.html", data, d, select_documents(data.documents, d), options, true, false, strip_tags(result["title"].GetString()));
-                    }
+        std::cout << std::endl;
+        std::cout << comparisons.size() << " compared, " << faster << " faster, " << slower << " slower, " << regressions << " regressions";
+        std::cout << " (" << only_old << " only in old, " << only_new << " only in new)" << std::endl;
+    }
 
-                    pages.insert(file);
-                }
-            }
+    //The regressions fail the continuous integration
+    return regressions ? 1 : 0;
+}
 
-            for(const auto& section : d["sections"]){
-                auto file = cpm::filify(d["compiler"].GetString(), d["configuration"].GetString(), std::string("section_") + strip_tags(section["name"].GetString()));
-                if(!pages.count(file)){
-                    generate_standard_page<Theme>(target_folder, file, data, d, select_documents(data.documents, d), options, true, true, strip_tags(section["name"].GetString()));
+} //end of anonymous namespace
 
-                    if(pages.empty()){
-                        generate_standard_page<Theme>(target_folder, "index.html", data, d, select_documents(data.documents, d), options, true, true, strip_tags(section["name"].GetString()));
-                    }
+int main(int argc, char* argv[]){
+    if(argc > 1 && str_equal(argv[1], "merge")){
+        return merge(argc, argv);
+    }
 
-                    pages.insert(file);
-                }
-            }
-        });
-    } else {
-        //Generate the index
-        generate_standard_page<Theme>(target_folder, "index.html", data, base, select_documents(data.documents, base), options);
+    if(argc > 1 && str_equal(argv[1], "convert")){
+        return convert(argc, argv);
+    }
 
-        //Generate the compiler pages
-        std::for_each(data.documents.rbegin(), data.documents.rend(), [&](cpm::document_t& d){
-            auto file = cpm::filify(d["compiler"].GetString(), d["configuration"].GetString());
-            if(!pages.count(file)){
-                generate_standard_page<Theme>(target_folder, file, data, d, select_documents(data.documents, d), options);
-                pages.insert(file);
-            }
-        });
+    if(argc > 1 && str_equal(argv[1], "query")){
+        return query(argc - 1, argv + 1);
     }
-}
 
-} //end of anonymous namespace
+    if(argc > 1 && str_equal(argv[1], "compare")){
+        return compare_runs(argc - 1, argv + 1);
+    }
 
-int main(int argc, char* argv[]){
-    cxxopts::Options options(argv[0], "  results_folder");
+    cxxopts::Options options(argv[0], "  results_folder | merge output.cpm shard.cpm... | convert input output | query results_folder | compare old new");
 
     try {
         options.add_options()
             ("time-sizes", "Display multiple sizes in the time graphs")
+            ("time-points", "Maximum number of runs in the time graphs before zooming, 0 for all", cxxopts::value<std::size_t>()->default_value("500"), "points")
+            ("downsampling", "Downsampling of the time graphs [lttb,minmax]", cxxopts::value<std::string>()->default_value("lttb"), "method")
             ("t,theme", "Theme name [raw,bootstrap,boostrap-tabs]", cxxopts::value<std::string>()->default_value("bootstrap"))
             ("c,hctheme", "Highcharts Theme name [std,dark_unica]", cxxopts::value<std::string>()->default_value("dark_unica"), "theme_name")
             ("o,output", "Output folder", cxxopts::value<std::string>()->default_value("reports"), "output_folder")
@@ -1330,6 +2815,9 @@ int main(int argc, char* argv[]){
             ("disable-compiler", "Disable compiler graphs")
             ("disable-configuration", "Disable configuration graphs")
             ("disable-summary", "Disable summary table")
+            ("f,force", "Generate all the pages, even the unchanged ones")
+            ("regression-threshold", "Minimum shift of the time to report, in percent", cxxopts::value<double>()->default_value("5"), "percent")
+            ("fail-on-regression", "Exit with an error if a regression happened in the latest runs")
             ("h,help", "Print help")
             ;
 
@@ -1366,33 +2854,64 @@ int main(int argc, char* argv[]){
 
     cpm::reports_data data;
 
-    //Get all the documents
-    data.documents = read(source_folder, options);
+    cpm::report_cache cache(target_folder);
+    cpm::report_changes changes;
 
-    if(data.documents.empty()){
-        std::cout << "Unable to read any files" << std::endl;
-        return -1;
-    }
+    changes.all = options.count("force");
+
+    {
+        //Get all the runs
+        auto documents = read(source_folder, options, cache, changes);
+
+        if(documents.empty()){
+            std::cout << "Unable to read any files" << std::endl;
+            return -1;
+        }
 
-    //Collect the list of compilers
-    for(auto& doc : data.documents){
-        data.compilers.insert(doc["compiler"].GetString());
+        for(auto& source : documents){
+            if(source.file){
+                add_run(data, *source.file);
+            } else {
+                add_run(data, source.doc);
+            }
+        }
     }
 
-    //Collect the list of configurations
-    for(auto& doc : data.documents){
-        data.configurations.insert(doc["configuration"].GetString());
+    data.build_index();
+
+    //The documents are destroyed, their memory can be released
+    kept_alive<cpm::file_mapping>().clear();
+    kept_alive<cpm::document_t::AllocatorType>().clear();
+
+    //Collect the list of compilers and configurations
+    for(auto& run : data.runs){
+        data.compilers.insert(data.str(run.compiler));
+        data.configurations.insert(data.str(run.configuration));
     }
 
+    auto shifts = generate_data(target_folder, data, options, cache, changes);
+
     if(options["theme"].as<std::string>() == "raw"){
-        generate_pages<cpm::raw_theme>(target_folder, data, options);
+        generate_pages<cpm::raw_theme>(target_folder, data, options, cache, changes, shifts);
     } else if(options["theme"].as<std::string>() == "bootstrap-tabs"){
-        generate_pages<cpm::bootstrap_tabs_theme>(target_folder, data, options);
+        generate_pages<cpm::bootstrap_tabs_theme>(target_folder, data, options, cache, changes, shifts);
     } else if(options["theme"].as<std::string>() == "bootstrap"){
-        generate_pages<cpm::bootstrap_theme>(target_folder, data, options);
+        generate_pages<cpm::bootstrap_theme>(target_folder, data, options, cache, changes, shifts);
     } else {
         std::cout << "Invalid theme" << std::endl;
     }
 
+    cache.save();
+
+    //The regressions still in effect fail the continuous integration
+    if(options.count("fail-on-regression")){
+        auto recent = std::count_if(shifts.begin(), shifts.end(), [](const report_shift& shift){ return shift.regression() && shift.recent; });
+
+        if(recent){
+            std::cout << "cpm: " << recent << " recent regression(s) detected, see regressions.html" << std::endl;
+            return 1;
+        }
+    }
+
     return 0;
 }
@@ -0,0 +1,329 @@
+R"=====(
+/**
+ * Lazy charts of the CPM reports
+ *
+ * The results of each bench (or section) are stored once in a data file
+ * shared by all the pages. The data file of a chart is only loaded when the
+ * chart becomes visible (scrolled into view or its tab opened) and the
+ * chart is then built from the data, like the report generator would.
+ */
+
+var cpm = (function(){
+    var runs = {};
+    var order = [];
+    var groups = {};
+    var waiting = {};
+    var config = {};
+
+    var index = null;
+    var index_loading = false;
+
+    function script(file){
+        var element = document.createElement('script');
+        element.src = file;
+        document.getElementsByTagName('head')[0].appendChild(element);
+    }
+
+    function load(file, callback){
+        if(groups[file]){
+            callback(groups[file]);
+        } else if(waiting[file]){
+            waiting[file].push(callback);
+        } else {
+            waiting[file] = [callback];
+            script(file);
+        }
+    }
+
+    function find(group, run, impl){
+        return group.lookup[run + '/' + impl];
+    }
+
+    function names(group, s){
+        return s[2].map(function(i){ return group.sizes[i]; });
+    }
+
+    function last(s){
+        return s[3][s[3].length - 1];
+    }
+
+    //All the sizes of the series, in order of appearance
+    function all_sizes(group, list){
+        var seen = {};
+        var sizes = [];
+
+        list.forEach(function(s){
+            s[2].forEach(function(i){
+                if(!seen[i]){
+                    seen[i] = true;
+                    sizes.push(group.sizes[i]);
+                }
+            });
+        });
+
+        return sizes;
+    }
+
+    //Shade the contiguous sizes sharing the same cache regime
+    function bands(group, s){
+        var regimes = s ? s[4] : 0;
+
+        if(!regimes || !regimes.length || regimes[0] < 0){
+            return undefined;
+        }
+
+        var colors = ['rgba(68, 170, 213, 0.1)', 'rgba(68, 170, 213, 0.2)'];
+        var result = [];
+        var begin = 0;
+
+        for(var i = 0; i < regimes.length; ++i){
+            if(regimes[i] < 0){
+                break;
+            }
+
+            if(i + 1 == regimes.length || regimes[i] != regimes[i + 1]){
+                result.push({ from: begin - 0.5, to: i + 0.5, color: colors[result.length % 2], label: { text: group.regimes[regimes[i]], verticalAlign: 'top' } });
+                begin = i + 1;
+            }
+        }
+
+        return result;
+    }
+
+    function draw(element, spec, group){
+        var base = runs[spec.run];
+
+        if(!base){
+            return;
+        }
+
+        var top = { align: 'left', verticalAlign: 'top', floating: false, borderWidth: 0, y: 20 };
+
+        var options = {
+            title: { text: spec.title, x: -20 },
+            yAxis: {
+                title: { text: config.mflops ? 'Throughput [MFlops/s]' : 'Time [ns]' },
+                plotLines: [{ value: 0, width: 1, color: '#808080'}]
+            },
+            tooltip: { valueSuffix: config.mflops ? 'MFlops/s' : 'ns' },
+            series: []
+        };
+
+        var own = group.series.filter(function(s){ return s[0] == spec.run; });
+
+        if(spec.graph == 'run'){
+            options.xAxis = { categories: spec.section ? all_sizes(group, own) : own.length ? names(group, own[0]) : [], plotBands: bands(group, own[0]) };
+
+            if(spec.section){
+                options.legend = top;
+                options.series = own.map(function(s){ return { name: group.impls[s[1]], data: s[3] }; });
+            } else {
+                options.legend = { enabled: false };
+                options.series = own.length ? [{ name: '', data: own[0][3] }] : [];
+            }
+        } else if(spec.graph == 'time'){
+            options.xAxis = { type: 'datetime', title: { text: 'Date' } };
+
+            var relevant = order.filter(function(id){
+                return runs[id].compiler == base.compiler && runs[id].configuration == base.configuration;
+            });
+
+            //The runs kept by the downsampling or, once zoomed, all the runs of the range
+            var points = function(impl, value, min, max){
+                var data = [];
+
+                relevant.forEach(function(id){
+                    var s = find(group, id, impl);
+                    var x = runs[id].timestamp * 1000;
+
+                    if(!s || (min === undefined ? s[5] === 0 : x < min || x > max)){
+                        return;
+                    }
+
+                    var v = value(s);
+
+                    if(v !== undefined){
+                        data.push([x, v]);
+                    }
+                });
+
+                return data;
+            };
+
+            var build = function(min, max){
+                if(spec.section){
+                    return own.map(function(b){ return { name: group.impls[b[1]], data: points(b[1], last, min, max) }; });
+                } else if(config.time_sizes){
+                    return own.length ? own[0][2].map(function(size){
+                        return { name: group.sizes[size], data: points(0, function(s){ var i = s[2].indexOf(size); return i < 0 ? undefined : s[3][i]; }, min, max) };
+                    }) : [];
+                } else {
+                    return [{ name: '', data: points(0, last, min, max) }];
+                }
+            };
+
+            if(spec.section){
+                options.legend = top;
+            } else if(!config.time_sizes){
+                options.legend = { enabled: false };
+            }
+
+            options.series = build();
+
+            //Mark the shifts detected by the report generator
+            options.xAxis.plotLines = (group.shifts || []).filter(function(c){
+                return relevant.indexOf(c[0]) >= 0 && (spec.section || c[1] == 0);
+            }).map(function(c){
+                var change = 100 * (c[3] - c[2]) / c[2];
+
+                return {
+                    value: runs[c[0]].timestamp * 1000, width: 2, dashStyle: 'Dash', color: change > 0 ? '#d9534f' : '#5cb85c',
+                    label: { text: (change > 0 ? '+' : '') + change.toFixed(1) + '%' + (spec.section ? ' ' + group.impls[c[1]] : ''), rotation: 90 }
+                };
+            });
+
+            //Full resolution on zoom, the downsampled runs once reset
+            options.chart = {
+                zoomType: 'x',
+                events: {
+                    selection: function(e){
+                        var series = e.resetSelection ? build() : build(e.xAxis[0].min, e.xAxis[0].max);
+
+                        this.series.forEach(function(s, i){
+                            s.setData(series[i].data, false);
+                        });
+
+                        return true;
+                    }
+                }
+            };
+        } else {
+            //Compare the compilers (or the configurations) of the same tag
+            var other = spec.graph == 'compiler' ? 'configuration' : 'compiler';
+            var impl = spec.section ? group.impls.indexOf(spec.impl) : 0;
+
+            options.xAxis = { categories: spec.section ? all_sizes(group, own) : own.length ? names(group, own[0]) : [] };
+            options.legend = top;
+
+            order.forEach(function(id){
+                if(runs[id].tag == base.tag && runs[id][other] == base[other]){
+                    var s = find(group, id, impl);
+
+                    if(s){
+                        options.series.push({ name: runs[id][spec.graph], data: s[3] });
+                    }
+                }
+            });
+        }
+
+        $(element).highcharts(options);
+    }
+
+    function filter(){
+        var input = document.getElementById('cpm_search');
+        var list = document.getElementById('cpm_search_results');
+
+        if(!input || !list){
+            return;
+        }
+
+        if(index === null){
+            if(!index_loading){
+                index_loading = true;
+                script('data/index.js');
+            }
+
+            return;
+        }
+
+        var query = input.value.toLowerCase();
+        var count = 0;
+
+        list.innerHTML = '';
+
+        for(var i = 0; query.length && i < index.length && count < 50; ++i){
+            var entry = index[i];
+
+            if(entry[1] == config.compiler && entry[2] == config.configuration && entry[0].toLowerCase().indexOf(query) >= 0){
+                var item = document.createElement('li');
+                var link = document.createElement('a');
+
+                link.href = entry[3];
+                link.textContent = entry[0];
+
+                item.appendChild(link);
+                list.appendChild(item);
+
+                ++count;
+            }
+        }
+
+        list.style.display = count ? 'block' : 'none';
+    }
+
+    document.addEventListener('DOMContentLoaded', function(){
+        var input = document.getElementById('cpm_search');
+
+        if(input){
+            input.addEventListener('input', filter);
+        }
+    });
+
+    return {
+        configure: function(values){
+            config = values;
+        },
+
+        runs: function(list){
+            list.forEach(function(r){
+                runs[r[0]] = { tag: r[1], compiler: r[2], configuration: r[3], timestamp: r[4] };
+                order.push(r[0]);
+            });
+        },
+
+        data: function(file, group){
+            group.lookup = {};
+
+            group.series.forEach(function(s){
+                var key = s[0] + '/' + s[1];
+
+                if(!(key in group.lookup)){
+                    group.lookup[key] = s;
+                }
+            });
+
+            groups[file] = group;
+
+            (waiting[file] || []).forEach(function(callback){ callback(group); });
+            delete waiting[file];
+        },
+
+        index: function(entries){
+            index = entries;
+            filter();
+        },
+
+        chart: function(id, spec){
+            var element = document.getElementById(id);
+
+            var show = function(){
+                load(spec.file, function(group){ draw(element, spec, group); });
+            };
+
+            if(!element || !window.IntersectionObserver){
+                show();
+                return;
+            }
+
+            var observer = new IntersectionObserver(function(entries){
+                if(entries.some(function(e){ return e.isIntersecting; })){
+                    observer.disconnect();
+                    show();
+                }
+            }, { rootMargin: '200px' });
+
+            observer.observe(element);
+        }
+    };
+})();
+)====="